@@ -0,0 +1,241 @@
+/**
+ * bench_compare.cpp — A/B regression gate for two chronostore_bench builds
+ *
+ * Runs both binaries for N interleaved trials (base/new, new/base, ...) so
+ * slow drift such as thermal throttling or background load hits both
+ * builds equally. Every run uses --format csv plus the same pinning,
+ * warm-up and extra arguments. For each phase it then compares ops/s and
+ * p99 latency with Welch's t-test, plus bytes per key for --memory runs.
+ *
+ * A phase regresses when the new build is worse by more than --threshold
+ * percent AND the difference is significant at --alpha. Exit status is
+ * 1 if anything regressed, 0 otherwise and 2 on usage or run errors, so
+ * the tool can gate a CI step directly.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 bench_compare.cpp -o chronostore_bench_compare
+ *
+ * Run:
+ *   ./chronostore_bench_compare --base ./chronostore_bench.base --new ./chronostore_bench
+ *       [--trials 5] [--pin 2] [--warmup 1] [--threshold 3] [--alpha 0.05]
+ *       [-- <extra chronostore_bench args>]
+ *
+ * Both builds must support --format csv.
+ */
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ─── Statistics ──────────────────────────────────────────────────────────────
+
+struct Sample {
+    double mean = 0;
+    double var  = 0; // unbiased sample variance
+    size_t n    = 0;
+};
+
+static Sample summarise(const std::vector<double>& xs) {
+    Sample s;
+    s.n = xs.size();
+    if (s.n == 0) return s;
+    for (double x : xs) s.mean += x;
+    s.mean /= static_cast<double>(s.n);
+    if (s.n > 1) {
+        for (double x : xs) s.var += (x - s.mean) * (x - s.mean);
+        s.var /= static_cast<double>(s.n - 1);
+    }
+    return s;
+}
+
+// Continued fraction for the regularised incomplete beta (Numerical Recipes).
+static double betaContinuedFraction(double a, double b, double x) {
+    const int    MAX_ITER = 200;
+    const double EPS = 3e-14, FPMIN = 1e-300;
+    double qab = a + b, qap = a + 1, qam = a - 1;
+    double c = 1, d = 1 - qab * x / qap;
+    if (std::fabs(d) < FPMIN) d = FPMIN;
+    d = 1 / d;
+    double h = d;
+    for (int m = 1; m <= MAX_ITER; ++m) {
+        int    m2 = 2 * m;
+        double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+        d = 1 + aa * d; if (std::fabs(d) < FPMIN) d = FPMIN;
+        c = 1 + aa / c; if (std::fabs(c) < FPMIN) c = FPMIN;
+        d = 1 / d;
+        h *= d * c;
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+        d = 1 + aa * d; if (std::fabs(d) < FPMIN) d = FPMIN;
+        c = 1 + aa / c; if (std::fabs(c) < FPMIN) c = FPMIN;
+        d = 1 / d;
+        double del = d * c;
+        h *= del;
+        if (std::fabs(del - 1) < EPS) break;
+    }
+    return h;
+}
+
+static double incompleteBeta(double a, double b, double x) {
+    if (x <= 0) return 0;
+    if (x >= 1) return 1;
+    double bt = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b)
+                         + a * std::log(x) + b * std::log(1 - x));
+    if (x < (a + 1) / (a + b + 2)) return bt * betaContinuedFraction(a, b, x) / a;
+    return 1 - bt * betaContinuedFraction(b, a, 1 - x) / b;
+}
+
+// Two-sided p-value of Welch's t-test; 1.0 when it cannot be computed.
+static double welchP(const Sample& x, const Sample& y) {
+    if (x.n < 2 || y.n < 2) return 1.0;
+    double vx = x.var / static_cast<double>(x.n);
+    double vy = y.var / static_cast<double>(y.n);
+    if (vx + vy <= 0) return x.mean == y.mean ? 1.0 : 0.0;
+    double t  = (x.mean - y.mean) / std::sqrt(vx + vy);
+    double df = (vx + vy) * (vx + vy)
+              / (vx * vx / static_cast<double>(x.n - 1) + vy * vy / static_cast<double>(y.n - 1));
+    return incompleteBeta(df / 2, 0.5, df / (df + t * t));
+}
+
+// ─── Running the benchmark ───────────────────────────────────────────────────
+
+struct Options {
+    std::string base, next;
+    int         trials    = 5;
+    std::string pin       = "0";
+    double      warmup    = 1.0;
+    double      threshold = 3.0;  // percent
+    double      alpha     = 0.05;
+    std::string extra;            // already shell-quoted
+};
+
+static std::string shellQuote(const std::string& s) {
+    std::string q = "'";
+    for (char c : s) q += (c == '\'') ? std::string("'\\''") : std::string(1, c);
+    return q + "'";
+}
+
+// phase → metric → samples
+using Samples = std::map<std::string, std::map<std::string, std::vector<double>>>;
+
+static void runOnce(const Options& o, const std::string& binary, Samples& out) {
+    std::ostringstream cmd;
+    cmd << shellQuote(binary) << " --format csv --pin " << shellQuote(o.pin)
+        << " --warmup " << o.warmup << o.extra;
+    FILE* pipe = popen(cmd.str().c_str(), "r");
+    if (!pipe) throw std::runtime_error("cannot run " + binary);
+
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), pipe)) > 0) text.append(buf, n);
+    if (pclose(pipe) != 0) throw std::runtime_error(binary + " exited with an error");
+
+    std::istringstream lines(text);
+    std::string line, header;
+    if (!std::getline(lines, header) || header.rfind("phase,", 0) != 0)
+        throw std::runtime_error(binary + " did not produce CSV (needs --format csv support)");
+
+    std::vector<std::string> cols;
+    { std::istringstream h(header); std::string c; while (std::getline(h, c, ',')) cols.push_back(c); }
+
+    while (std::getline(lines, line)) {
+        std::istringstream row(line);
+        std::string cell, phase;
+        for (size_t i = 0; std::getline(row, cell, ','); ++i) {
+            if (i == 0) { phase = cell; continue; }
+            if (i < cols.size()) out[phase][cols[i]].push_back(std::stod(cell));
+        }
+    }
+}
+
+static Options parseArgs(int argc, char* argv[]) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--") {
+            for (++i; i < argc; ++i) o.extra += " " + shellQuote(argv[i]);
+            break;
+        }
+        if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+        if      (arg == "--base")      o.base      = argv[++i];
+        else if (arg == "--new")       o.next      = argv[++i];
+        else if (arg == "--trials")    o.trials    = std::stoi(argv[++i]);
+        else if (arg == "--pin")       o.pin       = argv[++i];
+        else if (arg == "--warmup")    o.warmup    = std::stod(argv[++i]);
+        else if (arg == "--threshold") o.threshold = std::stod(argv[++i]);
+        else if (arg == "--alpha")     o.alpha     = std::stod(argv[++i]);
+        else throw std::invalid_argument("unknown option " + arg);
+    }
+    if (o.base.empty() || o.next.empty())
+        throw std::invalid_argument("--base and --new are required");
+    if (o.trials < 2) throw std::invalid_argument("--trials must be >= 2");
+    return o;
+}
+
+int main(int argc, char* argv[]) {
+    Options o;
+    try {
+        o = parseArgs(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << "bench_compare: " << ex.what() << "\n"
+                  << "usage: chronostore_bench_compare --base BIN --new BIN [--trials N]"
+                     " [--pin CPUS] [--warmup SECS] [--threshold PCT] [--alpha A] [-- ARGS]\n";
+        return 2;
+    }
+
+    Samples base, next;
+    try {
+        for (int t = 0; t < o.trials; ++t) {
+            std::cerr << "  trial " << (t + 1) << "/" << o.trials << " ...\r" << std::flush;
+            // ABBA ordering: neither build always runs first.
+            if (t % 2 == 0) { runOnce(o, o.base, base); runOnce(o, o.next, next); }
+            else            { runOnce(o, o.next, next); runOnce(o, o.base, base); }
+        }
+        std::cerr << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "bench_compare: " << ex.what() << "\n";
+        return 2;
+    }
+
+    // metric, higher-is-better
+    const std::vector<std::pair<std::string, bool>> metrics = {
+        {"ops_per_sec", true}, {"p99_ns", false}, {"heap_bytes_per_key", false}};
+
+    int regressions = 0;
+    std::cout << std::fixed << std::left << std::setw(22) << "phase" << std::setw(13) << "metric"
+              << std::right << std::setw(14) << "base" << std::setw(14) << "new"
+              << std::setw(9) << "delta" << std::setw(9) << "p" << "\n";
+    for (auto& [phase, base_metrics] : base) {
+        auto nit = next.find(phase);
+        if (nit == next.end()) continue;
+        for (auto& [metric, higher_better] : metrics) {
+            auto bs = base_metrics.find(metric);
+            auto ns = nit->second.find(metric);
+            if (bs == base_metrics.end() || ns == nit->second.end()) continue;
+
+            Sample b = summarise(bs->second), n = summarise(ns->second);
+            double delta = b.mean != 0 ? 100.0 * (n.mean - b.mean) / b.mean : 0.0;
+            double p     = welchP(b, n);
+            double worse = higher_better ? -delta : delta;
+            bool   regressed = worse > o.threshold && p < o.alpha;
+            bool   improved  = -worse > o.threshold && p < o.alpha;
+            if (regressed) ++regressions;
+
+            std::cout << std::left << std::setw(22) << phase << std::setw(13) << metric
+                      << std::right << std::setprecision(1)
+                      << std::setw(14) << b.mean << std::setw(14) << n.mean
+                      << std::showpos << std::setw(8) << delta << "%" << std::noshowpos
+                      << std::setprecision(3) << std::setw(9) << p
+                      << (regressed ? "  REGRESSION" : improved ? "  improved" : "") << "\n";
+        }
+    }
+
+    std::cout << std::defaultfloat << "\n" << regressions << " significant regression(s) across " << o.trials
+              << " trial(s) (threshold " << o.threshold << "%, alpha " << o.alpha << ")\n";
+    return regressions ? 1 : 0;
+}
@@ -2,26 +2,525 @@
  * benchmark.cpp — ChronoStore Throughput Benchmark
  *
  * Measures:
- *   1. Sequential WRITE: 100,000 SET ops
- *   2. Sequential READ : 100,000 GET ops (all hits)
- *   3. Random    READ : 100,000 GET ops (random keys, ~50% hit rate)
- *   4. Mixed     R/W  : 100,000 ops (70% GET, 30% SET)
+ *   1. Sequential WRITE: SET ops
+ *   2. Sequential READ : GET ops (all hits)
+ *   3. Random    READ : GET ops (random keys, ~50% hit rate)
+ *   4. Mixed     R/W  : 70% GET, 30% SET
+ *   5. SET with TTL
+ *   6. LRU eviction stress
+ *
+ * Every phase can run on N threads against one shared KVStore. Each thread
+ * times every operation into its own LatencyHistogram; the histograms are
+ * merged per phase to report tail latency alongside throughput.
  *
  * Compile:
  *   g++ -std=c++17 -O2 -pthread benchmark.cpp store.cpp -o chronostore_bench
  *
  * Run:
- *   ./chronostore_bench
+ *   ./chronostore_bench [--threads N] [--ops N] [--duration SECS]
+ *
+ *   --threads N      worker threads per phase (default 1)
+ *   --ops N          operations per phase, split across threads (default 100k)
+ *   --duration SECS  run each phase for SECS seconds instead of a fixed op count
+ *
+ * YCSB mode (replaces the six phases above):
+ *   --workload W         a..f, or "all" — YCSB core workloads A–F
+ *   --records N          records inserted by the load phase (default 100k)
+ *   --distribution D     override the request distribution:
+ *                        uniform | zipfian | scrambled | latest
+ *   --value-size N|A:B   value bytes, fixed or uniform in [A, B] (default 100)
+ *   --capacity N         store capacity (default: room for every record)
+ *   --eviction-policy P  lru | tinylfu | arc | sieve, a comma list, or "all": the store's
+ *                        policy; with several, each workload runs once per
+ *                        policy and its phases are suffixed "@policy"
+ *   --evict-headroom PCT evict in the background PCT% under capacity, with
+ *                        lazy free of evicted values
+ *
+ * Hit-ratio mode (replaces the phases above; single-threaded, cache-aside):
+ *   --hit-ratio          replay synthetic traces over --records keys through
+ *                        a --capacity store (default records / 10) for every
+ *                        --eviction-policy (default all) and report hit ratios:
+ *                          zipfian    Zipfian(0.99) reads
+ *                          zipf+scan  the same, interrupted by three full
+ *                                     sequential scans (scan reads not counted)
+ *                          loop       cyclic reads over 1.5 × capacity keys
+ *                          shifting   zipfian, then a sliding recency window,
+ *                                     then the loop, then zipfian again
+ *                        Each trace is 10 × records reads.
+ *   --trace FILE         replay a recorded trace instead (repeatable): one key
+ *                        per line, optionally after GET/SET; capacity defaults
+ *                        to distinct keys / 10
+ *
+ * Open-loop mode (fixed arrival rate, no coordinated omission):
+ *   --open-loop R1,R2,…  target rates in ops/s, or "auto" to sweep 10%–125%
+ *                        of the measured closed-loop capacity
+ *   --target T           inproc (default) | unix:PATH | shm:NAME
+ *                        (a shm segment serves one client: --threads 1)
+ *
+ *   Each thread issues requests on a fixed schedule; latency is measured
+ *   from the *intended* start time, so a stall (TTL tick, SAVE, lock
+ *   convoy) is charged to every request that should have run during it.
+ *   The op mix is the workload's read fraction (default B = 95% GET);
+ *   everything else is a SET. Runs --duration seconds per rate (default 2).
+ *
+ * Memory-footprint mode (replaces the phases above):
+ *   --memory            fill a store with --records keys per size mix, with and
+ *                       without TTLs, and report RSS delta, allocator bytes and
+ *                       overhead bytes per key
+ *   --key-size N|A:B    key bytes, fixed or uniform in [A, B]; with --value-size
+ *                       this selects a single mix instead of the default set
+ *
+ * Reporting / reproducibility:
+ *   --format F      text (default) | csv | json — csv/json print one record per
+ *                   phase (threads, ops/s, percentiles, RSS, CPU time) to stdout
+ *                   and nothing else
+ *   --pin CPUS      pin the process to CPUs, e.g. "2" or "2-5" (Linux)
+ *   --warmup SECS   run a throwaway mixed workload first (caches, allocator,
+ *                   CPU frequency) before anything is measured
+ *   --perf          count cycles, instructions, L1d/LLC misses, branch misses
+ *                   and context switches per phase (perf_event_open, Linux),
+ *                   reported per operation; counts include the harness's own
+ *                   per-op work (clock reads, RNG, key formatting)
  */
 #include "store.h"
+#include "histogram.h"
+#include "perf_counters.h"
+#include "workload.h"
+#ifndef _WIN32
+#include "shm_ring.h"
+#include "unix_server.h"
+
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
-using hrc = std::chrono::high_resolution_clock;
+using hrc = std::chrono::steady_clock;
+
+// ─── Configuration ───────────────────────────────────────────────────────────
+
+static constexpr size_t N           = 100'000;
+static constexpr size_t BENCH_CAP   = 200'000; // large enough to avoid eviction in write test
+
+struct BenchConfig {
+    size_t threads    = 1;
+    size_t ops        = N;   // per phase, all threads together
+    double duration_s = 0;   // > 0 → time-bound phases, `ops` ignored
+
+    // YCSB mode
+    std::string workloads;          // e.g. "abcdef"; empty = classic phases
+    size_t      records   = N;
+    std::string distribution;       // empty = workload default
+    size_t      value_min = 100;
+    size_t      value_max = 100;
+    size_t      capacity  = 0;      // 0 = records + inserts
+
+    std::string policies;           // --eviction-policy list; empty = lru (hit-ratio: all)
+    double      evict_headroom = 0; // percent; > 0 = async eviction + lazy free
+
+    // Hit-ratio mode
+    bool                     hit_ratio = false;
+    std::vector<std::string> traces;    // --trace files; empty = synthetic traces
+
+    // Memory-footprint mode
+    bool   memory     = false;
+    size_t key_min    = 16;
+    size_t key_max    = 16;
+    bool   sizes_given = false;         // --key-size / --value-size seen
+
+    // Open-loop mode
+    std::string open_loop;          // "auto" or comma-separated rates; empty = off
+    std::string target = "inproc";  // inproc | unix:PATH | shm:NAME
+
+    // Reporting / reproducibility
+    std::string format = "text";    // text | csv | json
+    std::string pin;                // CPU list for sched_setaffinity
+    double      warmup_s = 0;
+    bool        perf     = false;   // hardware counters per phase
+};
+
+static BenchConfig parseArgs(int argc, char* argv[]) {
+    BenchConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--threads" || arg == "-t") && i + 1 < argc)
+            cfg.threads = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if ((arg == "--ops" || arg == "-n") && i + 1 < argc)
+            cfg.ops = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if ((arg == "--duration" || arg == "-d") && i + 1 < argc)
+            cfg.duration_s = std::stod(argv[++i]);
+        else if ((arg == "--workload" || arg == "-w") && i + 1 < argc) {
+            std::string w = argv[++i];
+            cfg.workloads = (w == "all") ? "abcdef" : w;
+        }
+        else if (arg == "--records" && i + 1 < argc)
+            cfg.records = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--distribution" && i + 1 < argc)
+            cfg.distribution = argv[++i];
+        else if ((arg == "--value-size" || arg == "--key-size") && i + 1 < argc) {
+            std::string v = argv[++i];
+            auto colon = v.find(':');
+            size_t lo = std::stoul(v.substr(0, colon));
+            size_t hi = colon == std::string::npos ? lo : std::stoul(v.substr(colon + 1));
+            if (arg == "--key-size") { cfg.key_min = lo;   cfg.key_max = hi; }
+            else                     { cfg.value_min = lo; cfg.value_max = hi; }
+            cfg.sizes_given = true;
+        }
+        else if (arg == "--memory")
+            cfg.memory = true;
+        else if (arg == "--hit-ratio")
+            cfg.hit_ratio = true;
+        else if (arg == "--trace" && i + 1 < argc)
+            cfg.traces.push_back(argv[++i]);
+        else if (arg == "--eviction-policy" && i + 1 < argc)
+            cfg.policies = argv[++i];
+        else if (arg == "--evict-headroom" && i + 1 < argc)
+            cfg.evict_headroom = std::stod(argv[++i]);
+        else if (arg == "--capacity" && i + 1 < argc)
+            cfg.capacity = std::stoul(argv[++i]);
+        else if (arg == "--open-loop" && i + 1 < argc)
+            cfg.open_loop = argv[++i];
+        else if (arg == "--target" && i + 1 < argc)
+            cfg.target = argv[++i];
+        else if (arg == "--format" && i + 1 < argc)
+            cfg.format = argv[++i];
+        else if (arg == "--pin" && i + 1 < argc)
+            cfg.pin = argv[++i];
+        else if (arg == "--warmup" && i + 1 < argc)
+            cfg.warmup_s = std::stod(argv[++i]);
+        else if (arg == "--perf")
+            cfg.perf = true;
+    }
+    return cfg;
+}
+
+// ─── Process resources ───────────────────────────────────────────────────────
+
+struct CpuTime {
+    double user_s = 0;
+    double sys_s  = 0;
+};
+
+static CpuTime processCpuTime() {
+    CpuTime t;
+#ifndef _WIN32
+    rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        t.user_s = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6;
+        t.sys_s  = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+    }
+#endif
+    return t;
+}
+
+// Current resident set in KiB (peak RSS where the current value is unavailable).
+static long processRssKb() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    long pages_total = 0, pages_resident = 0;
+    if (statm >> pages_total >> pages_resident)
+        return pages_resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+#ifndef _WIN32
+    rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0) return ru.ru_maxrss;
+#endif
+    return 0;
+}
+
+// Bytes currently allocated through malloc (all arenas + mmapped chunks), or
+// -1 where the allocator cannot report it.
+static long long heapInUseBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    return static_cast<long long>(mi.uordblks + mi.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+// Hands freed heap pages back to the OS so the next RSS baseline is clean.
+static void releaseFreeHeap() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+// "2" or "2-5" or "0,2,4" → sched_setaffinity. Returns false if unsupported.
+static bool pinToCpus(const std::string& list) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::stringstream ss(list);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        auto dash = part.find('-');
+        int lo = std::stoi(part.substr(0, dash));
+        int hi = dash == std::string::npos ? lo : std::stoi(part.substr(dash + 1));
+        for (int c = lo; c <= hi; ++c) CPU_SET(c, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)list;
+    return false;
+#endif
+}
+
+// ─── Phase runner ────────────────────────────────────────────────────────────
+
+struct PhaseResult {
+    size_t                   ops  = 0;
+    size_t                   hits = 0;  // ops for which the body returned true
+    std::chrono::nanoseconds wall{0};
+    LatencyHistogram         hist;
+    CpuTime                  cpu;       // process CPU time spent during the phase
+    PerfCounters::Sample     perf;      // all -1 unless --perf
+};
+
+// Opened once in main() when --perf is given; each phase start()s it just
+// before releasing its workers and stop()s it after joining them.
+static PerfCounters* g_perf = nullptr;
+
+/**
+ * Runs `op(i, rng)` on cfg.threads threads. Thread t executes op indices
+ * t, t+T, t+2T, ... until `ops` are done (or the deadline passes in
+ * duration mode), timing each call into a thread-local histogram.
+ * `op` returns true to count a hit.
+ */
+template <typename Op>
+static PhaseResult runPhase(const BenchConfig& cfg, size_t ops, Op op, uint32_t seed = 42) {
+    const size_t threads = cfg.threads;
+    const bool   timed   = cfg.duration_s > 0;
+
+    PhaseResult       result;
+    std::mutex        merge_mutex;
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            LatencyHistogram hist;
+            std::mt19937     rng(seed + static_cast<uint32_t>(t));
+            size_t           done = 0, hits = 0;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            for (size_t i = t; timed ? !stop.load(std::memory_order_relaxed) : i < ops;
+                 i += threads) {
+                auto t0 = hrc::now();
+                if (op(i, rng)) ++hits;
+                auto t1 = hrc::now();
+                hist.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+                ++done;
+            }
+
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            result.hist.merge(hist);
+            result.ops  += done;
+            result.hits += hits;
+        });
+    }
+
+    CpuTime cpu0  = processCpuTime();
+    if (g_perf) g_perf->start();
+    auto    start = hrc::now();
+    go.store(true, std::memory_order_release);
+    if (timed) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(cfg.duration_s));
+        stop.store(true);
+    }
+    for (auto& w : workers) w.join();
+    result.wall = hrc::now() - start;
+    if (g_perf) result.perf = g_perf->stop();
+    CpuTime cpu1 = processCpuTime();
+    result.cpu   = {cpu1.user_s - cpu0.user_s, cpu1.sys_s - cpu0.sys_s};
+    return result;
+}
+
+// ─── Machine-readable report ─────────────────────────────────────────────────
+
+struct ReportRow {
+    std::string phase;
+    size_t      threads = 0;
+    size_t      ops     = 0;
+    double      seconds = 0;
+    double      ops_per_sec = 0;
+    double      mean_ns = 0;
+    uint64_t    p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0;
+    long        rss_kb  = 0;
+    double      cpu_user_s = 0;
+    double      cpu_sys_s  = 0;
+    double      perf_per_op[PerfCounters::COUNT]; // -1 = not collected
+};
+
+static std::vector<ReportRow> g_report;
+
+// --memory results; a memory run reports these instead of latency rows.
+struct MemoryRow {
+    std::string phase;
+    size_t      records       = 0;
+    double      payload_bytes = 0;   // Σ key + value bytes
+    double      rss_delta     = 0;   // bytes
+    double      heap_delta    = 0;   // bytes, -1 if the allocator can't tell
+    double      used_memory   = 0;   // the store's own estimate (STATS used_memory)
+};
+
+static std::vector<MemoryRow> g_memory;
+
+struct HitRatioRow {
+    std::string phase;      // hit-ratio/<trace>/<policy>
+    size_t      accesses  = 0;
+    double      hit_ratio = 0;
+};
+
+static std::vector<HitRatioRow> g_hit_ratio;
+
+static void recordRow(const std::string& phase, size_t threads, const PhaseResult& r) {
+    ReportRow row;
+    row.phase       = phase;
+    row.threads     = threads;
+    row.ops         = r.ops;
+    row.seconds     = r.wall.count() / 1e9;
+    row.ops_per_sec = row.seconds > 0 ? static_cast<double>(r.ops) / row.seconds : 0;
+    row.mean_ns     = r.hist.mean();
+    row.p50         = r.hist.percentile(0.50);
+    row.p90         = r.hist.percentile(0.90);
+    row.p99         = r.hist.percentile(0.99);
+    row.p999        = r.hist.percentile(0.999);
+    row.max         = r.hist.max();
+    row.rss_kb      = processRssKb();
+    row.cpu_user_s  = r.cpu.user_s;
+    row.cpu_sys_s   = r.cpu.sys_s;
+    for (int e = 0; e < PerfCounters::COUNT; ++e)
+        row.perf_per_op[e] = r.perf.perOp(static_cast<PerfCounters::Event>(e), r.ops);
+    g_report.push_back(row);
+}
+
+// Memory rows carry per-key figures so bench-compare can diff data layouts.
+static void writeMemoryReport(std::ostream& out, const std::string& format) {
+    auto perKey = [](const MemoryRow& r, double bytes) {
+        return r.records ? bytes / static_cast<double>(r.records) : 0.0;
+    };
+    if (format == "csv") {
+        out << "phase,records,payload_bytes,rss_delta_bytes,heap_delta_bytes,"
+               "payload_per_key,heap_bytes_per_key,overhead_per_key,used_memory_per_key\n";
+        for (auto& r : g_memory) {
+            double used = r.heap_delta < 0 ? r.rss_delta : r.heap_delta;
+            out << r.phase << ',' << r.records << ',' << r.payload_bytes << ','
+                << r.rss_delta << ',' << r.heap_delta << ',' << perKey(r, r.payload_bytes) << ','
+                << perKey(r, used) << ',' << perKey(r, used - r.payload_bytes) << ','
+                << perKey(r, r.used_memory) << '\n';
+        }
+    } else if (format == "json") {
+        out << "[\n";
+        for (size_t i = 0; i < g_memory.size(); ++i) {
+            auto&  r    = g_memory[i];
+            double used = r.heap_delta < 0 ? r.rss_delta : r.heap_delta;
+            out << "  {\"phase\": \"" << r.phase << "\", \"records\": " << r.records
+                << ", \"payload_bytes\": " << r.payload_bytes
+                << ", \"rss_delta_bytes\": " << r.rss_delta
+                << ", \"heap_delta_bytes\": " << r.heap_delta
+                << ", \"payload_per_key\": " << perKey(r, r.payload_bytes)
+                << ", \"heap_bytes_per_key\": " << perKey(r, used)
+                << ", \"overhead_per_key\": " << perKey(r, used - r.payload_bytes)
+                << ", \"used_memory_per_key\": " << perKey(r, r.used_memory)
+                << "}" << (i + 1 < g_memory.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+}
+
+static void writeHitRatioReport(std::ostream& out, const std::string& format) {
+    if (format == "csv") {
+        out << "phase,accesses,hit_ratio\n";
+        for (auto& r : g_hit_ratio)
+            out << r.phase << ',' << r.accesses << ',' << std::setprecision(5) << r.hit_ratio << '\n';
+    } else if (format == "json") {
+        out << "[\n";
+        for (size_t i = 0; i < g_hit_ratio.size(); ++i) {
+            auto& r = g_hit_ratio[i];
+            out << "  {\"phase\": \"" << r.phase << "\", \"accesses\": " << r.accesses
+                << ", \"hit_ratio\": " << std::setprecision(5) << r.hit_ratio << "}"
+                << (i + 1 < g_hit_ratio.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+}
+
+// Counter columns are only emitted with --perf; unavailable events are -1
+// in CSV and null in JSON.
+static void writeReport(std::ostream& out, const std::string& format) {
+    out << std::fixed << std::setprecision(3);
+    if (!g_memory.empty()) {
+        writeMemoryReport(out, format);
+        return;
+    }
+    if (!g_hit_ratio.empty()) {
+        writeHitRatioReport(out, format);
+        return;
+    }
+    if (format == "csv") {
+        out << "phase,threads,ops,seconds,ops_per_sec,mean_ns,p50_ns,p90_ns,p99_ns,"
+               "p999_ns,max_ns,rss_kb,cpu_user_s,cpu_sys_s";
+        if (g_perf)
+            for (int e = 0; e < PerfCounters::COUNT; ++e)
+                out << ',' << PerfCounters::name(static_cast<PerfCounters::Event>(e)) << "_per_op";
+        out << '\n';
+        for (auto& r : g_report) {
+            out << r.phase << ',' << r.threads << ',' << r.ops << ',' << r.seconds << ','
+                << r.ops_per_sec << ',' << r.mean_ns << ',' << r.p50 << ',' << r.p90 << ','
+                << r.p99 << ',' << r.p999 << ',' << r.max << ',' << r.rss_kb << ','
+                << r.cpu_user_s << ',' << r.cpu_sys_s;
+            if (g_perf) {
+                out << std::setprecision(4);
+                for (double v : r.perf_per_op) out << ',' << v;
+                out << std::setprecision(3);
+            }
+            out << '\n';
+        }
+    } else if (format == "json") {
+        out << "[\n";
+        for (size_t i = 0; i < g_report.size(); ++i) {
+            auto& r = g_report[i];
+            out << "  {\"phase\": \"" << r.phase << "\", \"threads\": " << r.threads
+                << ", \"ops\": " << r.ops << ", \"seconds\": " << r.seconds
+                << ", \"ops_per_sec\": " << r.ops_per_sec << ", \"mean_ns\": " << r.mean_ns
+                << ", \"p50_ns\": " << r.p50 << ", \"p90_ns\": " << r.p90
+                << ", \"p99_ns\": " << r.p99 << ", \"p999_ns\": " << r.p999
+                << ", \"max_ns\": " << r.max << ", \"rss_kb\": " << r.rss_kb
+                << ", \"cpu_user_s\": " << r.cpu_user_s << ", \"cpu_sys_s\": " << r.cpu_sys_s;
+            if (g_perf)
+                for (int e = 0; e < PerfCounters::COUNT; ++e) {
+                    out << ", \"" << PerfCounters::name(static_cast<PerfCounters::Event>(e))
+                        << "_per_op\": ";
+                    if (r.perf_per_op[e] < 0) out << "null";
+                    else                      out << r.perf_per_op[e];
+                }
+            out << "}" << (i + 1 < g_report.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+}
 
 // ─── Formatting helpers ───────────────────────────────────────────────────────
 
@@ -31,26 +530,649 @@ static void printHeader(const std::string& title) {
     std::cout << "\033[1;36m  ==============================================\033[0m\n";
 }
 
-static void printResult(const std::string& label, size_t ops,
-                        std::chrono::nanoseconds duration) {
-    double secs    = duration.count() / 1e9;
-    double ops_sec = static_cast<double>(ops) / secs;
-    double ns_op   = static_cast<double>(duration.count()) / static_cast<double>(ops);
+// "  per op  cycles 812  instr 1430  IPC 1.76  L1d-miss 4.10 ..." (n/a = unavailable)
+static void printPerf(const PhaseResult& r) {
+    using PC = PerfCounters;
+    auto field = [&](const char* label, PC::Event e, int precision) {
+        std::cout << "  " << label << " ";
+        double v = r.perf.perOp(e, r.ops);
+        if (v < 0) std::cout << "n/a";
+        else       std::cout << std::setprecision(precision) << v;
+    };
+    std::cout << std::fixed << "  \033[90m  per op    ";
+    field("cycles", PC::CYCLES, 0);
+    field("instr", PC::INSTRUCTIONS, 0);
+    std::cout << "  IPC ";
+    if (r.perf.has(PC::CYCLES) && r.perf.has(PC::INSTRUCTIONS) && r.perf.values[PC::CYCLES] > 0)
+        std::cout << std::setprecision(2) << r.perf.values[PC::INSTRUCTIONS] / r.perf.values[PC::CYCLES];
+    else
+        std::cout << "n/a";
+    field("L1d-miss", PC::L1D_MISSES, 2);
+    field("LLC-miss", PC::LLC_MISSES, 3);
+    field("br-miss", PC::BRANCH_MISSES, 2);
+    field("ctx-sw", PC::CTX_SWITCHES, 4);
+    std::cout << (r.perf.user_only ? "  (user only)" : "") << "\033[0m\n";
+}
+
+// Prints one phase and records it for --format csv/json under `phase`
+// (defaults to the label).
+static void printResult(const std::string& label, const PhaseResult& r,
+                        size_t threads, std::string phase = "") {
+    recordRow(phase.empty() ? label : phase, threads, r);
+    double secs    = r.wall.count() / 1e9;
+    double ops_sec = static_cast<double>(r.ops) / secs;
+    const auto& h  = r.hist;
 
     std::cout << std::fixed;
     std::cout << "  \033[32m" << std::setw(18) << std::left << label << "\033[0m"
               << "  \033[33m" << std::setw(10) << std::right << std::setprecision(0)
               << ops_sec << " ops/s\033[0m"
-              << "  \033[90m(" << std::setprecision(1) << ns_op << " ns/op"
-              << "  total: " << std::setprecision(3) << secs << "s)\033[0m\n";
+              << "  \033[90m(" << r.ops << " ops, total: " << std::setprecision(3)
+              << secs << "s)\033[0m\n";
+    std::cout << "  \033[90m  latency ns  mean " << std::setprecision(0) << h.mean()
+              << "  p50 "   << h.percentile(0.50)
+              << "  p90 "   << h.percentile(0.90)
+              << "  p99 "   << h.percentile(0.99)
+              << "  p99.9 " << h.percentile(0.999)
+              << "  max "   << h.max() << "\033[0m\n";
+    if (r.perf.any()) printPerf(r);
+}
+
+// Per-lock contention since the store was created (LOCK_STATS builds only).
+static void printLocks(const Stats& s) {
+    for (auto& [name, l] : s.locks) {
+        double wait_us = static_cast<double>(l.wait_ns) / 1e3;
+        std::cout << "  \033[90m  lock " << std::setw(6) << std::left << name << std::right
+                  << std::setprecision(0) << l.acquisitions << " acq, "
+                  << l.contended << " contended ("
+                  << std::setprecision(2)
+                  << (l.acquisitions ? 100.0 * static_cast<double>(l.contended)
+                                           / static_cast<double>(l.acquisitions) : 0.0)
+                  << "%), wait " << std::setprecision(0) << wait_us << " us total / "
+                  << std::setprecision(0)
+                  << (l.contended ? wait_us * 1e3 / static_cast<double>(l.contended) : 0.0)
+                  << " ns avg, max hold " << l.max_hold_ns << " ns\033[0m\n";
+    }
+}
+
+// ─── YCSB workloads ──────────────────────────────────────────────────────────
+
+// --eviction-policy list → policies; empty means `fallback`.
+static std::vector<EvictionPolicy> parsePolicies(const std::string& list,
+                                                 std::vector<EvictionPolicy> fallback) {
+    if (list.empty()) return fallback;
+    if (list == "all")
+        return {std::begin(ALL_EVICTION_POLICIES), std::end(ALL_EVICTION_POLICIES)};
+    std::vector<EvictionPolicy> out;
+    std::stringstream ss(list);
+    std::string name;
+    while (std::getline(ss, name, ',')) out.push_back(parseEvictionPolicy(name));
+    return out;
+}
+
+// `suffix` (e.g. "@tinylfu") tells phases apart when several policies run.
+static void runYcsb(const BenchConfig& cfg, WorkloadSpec spec,
+                    EvictionPolicy policy = EvictionPolicy::LRU,
+                    const std::string& suffix = "") {
+    if (!cfg.distribution.empty()) spec.dist = parseDistribution(cfg.distribution);
+    printHeader(std::string("YCSB Workload ") + spec.name + ": " + spec.description
+                + " [" + distributionName(spec.dist) + ", " + evictionPolicyName(policy) + "]");
+
+    // Pre-generate every key the run can touch so formatting isn't timed.
+    const size_t records     = cfg.records;
+    const size_t max_inserts = spec.insert > 0
+        ? (cfg.duration_s > 0 ? records : cfg.ops) : 0;
+    std::vector<std::string> keys;
+    keys.reserve(records + max_inserts);
+    for (size_t i = 0; i < records + max_inserts; ++i)
+        keys.push_back("user" + std::to_string(i));
+    ValuePool values(cfg.value_min, cfg.value_max);
+
+    KVStore store(cfg.capacity ? cfg.capacity : keys.size(), 0, policy);
+    if (cfg.evict_headroom > 0) store.enableAsyncEviction(cfg.evict_headroom / 100.0);
+
+    // Load phase: insert records 0..records-1
+    BenchConfig load_cfg = cfg;
+    load_cfg.duration_s  = 0;
+    auto load = runPhase(load_cfg, records, [&](size_t i, std::mt19937& rng) {
+        store.set(keys[i], values.pick(rng));
+        return true;
+    });
+    printResult("Load", load, cfg.threads,
+                std::string("ycsb-") + spec.name + "/load" + suffix);
+
+    // Run phase
+    Stats before = store.stats();
+    std::atomic<uint64_t> inserted{records};
+    KeyChooser chooser(spec.dist, records);
+
+    auto run = runPhase(cfg, cfg.ops, [&](size_t, std::mt19937& rng) {
+        double p = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        auto   pick = [&] { return chooser.next(rng, inserted.load(std::memory_order_relaxed)); };
+
+        if ((p -= spec.read) < 0) {
+            // Cache-aside: a miss refills the record, so with --capacity below
+            // --records the hit ratio reflects the eviction policy.
+            const std::string& k = keys[pick()];
+            if (store.get(k)) return true;
+            store.set(k, values.pick(rng));
+            return false;
+        }
+        if ((p -= spec.update) < 0) {
+            store.set(keys[pick()], values.pick(rng));
+            return true;
+        }
+        if ((p -= spec.insert) < 0) {
+            uint64_t id = inserted.load(std::memory_order_relaxed);
+            if (id < keys.size()) {
+                store.set(keys[id], values.pick(rng));
+                inserted.fetch_add(1, std::memory_order_relaxed); // publish after write
+            }
+            return true;
+        }
+        if ((p -= spec.scan) < 0) {
+            uint64_t start = pick();
+            size_t   len   = std::uniform_int_distribution<size_t>(1, spec.max_scan_length)(rng);
+            uint64_t limit = inserted.load(std::memory_order_relaxed);
+            std::vector<std::string> range;
+            range.reserve(len);
+            for (uint64_t k = start; k < limit && range.size() < len; ++k)
+                range.push_back(keys[k]);
+            store.mget(range);
+            return true;
+        }
+        // Read-modify-write: optimistic GETS + CAS, one attempt
+        const std::string& k = keys[pick()];
+        auto cur = store.gets(k);
+        if (cur) store.cas(k, values.pick(rng), cur->version);
+        return true;
+    });
+    printResult("Run", run, cfg.threads,
+                std::string("ycsb-") + spec.name + "/run" + suffix);
+
+    Stats after  = store.stats();
+    uint64_t h   = after.hits   - before.hits;
+    uint64_t m   = after.misses - before.misses;
+    std::cout << "  \033[90m  → " << std::fixed << std::setprecision(1)
+              << (h + m ? 100.0 * static_cast<double>(h) / static_cast<double>(h + m) : 0.0)
+              << "% hit ratio, " << after.evictions << " evictions, "
+              << inserted.load() - records << " inserts\033[0m\n";
+    printLocks(after);
+}
+
+// ─── Open-loop driver ────────────────────────────────────────────────────────
+
+/**
+ * Target — where open-loop requests go. One instance per worker thread
+ * (socket and ring clients are not shareable).
+ */
+struct Target {
+    virtual ~Target() = default;
+    virtual bool get(const std::string& key) = 0;
+    virtual void set(const std::string& key, const std::string& value) = 0;
+};
+
+struct InProcTarget : Target {
+    explicit InProcTarget(KVStore& s) : store(s) {}
+    bool get(const std::string& key) override { return store.get(key).has_value(); }
+    void set(const std::string& key, const std::string& value) override { store.set(key, value); }
+    KVStore& store;
+};
+
+#ifndef _WIN32
+// Any wire client with request(line) → RESP reply.
+template <typename Client>
+struct WireTarget : Target {
+    template <typename... Args>
+    explicit WireTarget(Args&&... args) : client(std::forward<Args>(args)...) {}
+    bool get(const std::string& key) override {
+        return client.request("GET " + key).compare(0, 3, "$-1") != 0;
+    }
+    void set(const std::string& key, const std::string& value) override {
+        client.request("SET " + key + " " + value);
+    }
+    Client client;
+};
+#endif
+
+static std::unique_ptr<Target> makeTarget(const std::string& spec, KVStore& local) {
+    if (spec == "inproc") return std::make_unique<InProcTarget>(local);
+#ifndef _WIN32
+    if (spec.rfind("unix:", 0) == 0)
+        return std::make_unique<WireTarget<UnixSocketClient>>(spec.substr(5));
+    if (spec.rfind("shm:", 0) == 0)
+        return std::make_unique<WireTarget<ShmRingClient>>(spec.substr(4));
+#endif
+    throw std::invalid_argument("Unknown target: " + spec);
+}
+
+/**
+ * Runs one fixed-rate step: thread t issues op k at
+ *   start + (k * T + t) / rate
+ * and records completion − intended_start. A thread that falls behind does
+ * not skip or re-plan; its backlog shows up as queueing latency.
+ */
+static PhaseResult runOpenLoopStep(const BenchConfig& cfg, double rate,
+                                   std::vector<std::unique_ptr<Target>>& targets,
+                                   const std::vector<std::string>& keys,
+                                   const ValuePool& values, double read_fraction) {
+    const size_t threads = targets.size();
+    const auto   period  = std::chrono::duration<double>(static_cast<double>(threads) / rate);
+    const auto   length  = std::chrono::duration<double>(cfg.duration_s > 0 ? cfg.duration_s : 2.0);
+
+    PhaseResult result;
+    std::mutex  merge_mutex;
+    std::vector<std::thread> workers;
+    const auto    start = hrc::now() + std::chrono::milliseconds(10);
+    const CpuTime cpu0  = processCpuTime();
+    if (g_perf) g_perf->start();
+
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            LatencyHistogram hist;
+            std::mt19937     rng(42 + static_cast<uint32_t>(t));
+            KeyChooser       chooser(KeyDistribution::ZIPFIAN, keys.size());
+            Target&          target = *targets[t];
+            size_t           done = 0;
+            const auto offset = period * (static_cast<double>(t) / static_cast<double>(threads));
+
+            for (size_t k = 0;; ++k) {
+                auto intended = start + std::chrono::duration_cast<hrc::duration>(
+                                            offset + period * static_cast<double>(k));
+                if (intended - start > length) break;
+                auto now = hrc::now();
+                if (intended - now > std::chrono::microseconds(100))
+                    std::this_thread::sleep_until(intended - std::chrono::microseconds(50));
+                while (hrc::now() < intended) {}
+
+                const std::string& key = keys[chooser.next(rng, keys.size())];
+                if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < read_fraction)
+                    target.get(key);
+                else
+                    target.set(key, values.pick(rng));
+
+                hist.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    hrc::now() - intended).count()));
+                ++done;
+            }
+
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            result.hist.merge(hist);
+            result.ops += done;
+        });
+    }
+    for (auto& w : workers) w.join();
+    result.wall = hrc::now() - start;
+    if (g_perf) result.perf = g_perf->stop();
+    CpuTime cpu1 = processCpuTime();
+    result.cpu   = {cpu1.user_s - cpu0.user_s, cpu1.sys_s - cpu0.sys_s};
+    return result;
+}
+
+static void runOpenLoop(const BenchConfig& cfg) {
+    WorkloadSpec spec = ycsbWorkload(cfg.workloads.empty() ? 'b' : cfg.workloads[0]);
+    printHeader("Open-loop: " + cfg.target + ", " + std::to_string(spec.read * 100).substr(0, 4)
+                + "% GET, " + std::to_string(cfg.threads) + " thread(s)");
+
+    std::vector<std::string> keys;
+    keys.reserve(cfg.records);
+    for (size_t i = 0; i < cfg.records; ++i) keys.push_back("user" + std::to_string(i));
+    ValuePool values(cfg.value_min, cfg.value_max);
+
+    // Every thread needs its own client, and a segment admits one per process.
+    if (cfg.target.rfind("shm:", 0) == 0 && cfg.threads > 1)
+        throw std::invalid_argument("A shm target serves a single client; run it with --threads 1");
+
+    KVStore local(cfg.capacity ? cfg.capacity : cfg.records);
+    std::vector<std::unique_ptr<Target>> targets;
+    for (size_t t = 0; t < cfg.threads; ++t) targets.push_back(makeTarget(cfg.target, local));
+
+    // Load through the first target so remote stores get the records too.
+    {
+        std::mt19937 rng(1);
+        for (auto& k : keys) targets[0]->set(k, values.pick(rng));
+    }
+
+    std::vector<double> rates;
+    if (cfg.open_loop == "auto") {
+        // Closed-loop probe for capacity, then sweep around it.
+        BenchConfig probe = cfg;
+        probe.duration_s  = 0.5;
+        auto cap = runPhase(probe, 0, [&](size_t i, std::mt19937& rng) {
+            auto& target = *targets[i % targets.size()];
+            return target.get(keys[std::uniform_int_distribution<size_t>(0, keys.size() - 1)(rng)]);
+        });
+        double capacity = static_cast<double>(cap.ops) / (cap.wall.count() / 1e9);
+        std::cout << "  \033[90m  closed-loop capacity ≈ " << std::fixed << std::setprecision(0)
+                  << capacity << " ops/s\033[0m\n";
+        for (double f : {0.10, 0.25, 0.50, 0.75, 0.90, 1.00, 1.10, 1.25}) rates.push_back(f * capacity);
+    } else {
+        std::string list = cfg.open_loop;
+        size_t pos = 0;
+        while (pos <= list.size()) {
+            size_t comma = list.find(',', pos);
+            if (comma == std::string::npos) comma = list.size();
+            if (comma > pos) rates.push_back(std::stod(list.substr(pos, comma - pos)));
+            pos = comma + 1;
+        }
+    }
+
+    std::cout << "\n  " << std::setw(12) << "target/s" << std::setw(12) << "achieved/s"
+              << std::setw(12) << "p50 ns" << std::setw(12) << "p90"
+              << std::setw(12) << "p99"    << std::setw(12) << "p99.9"
+              << std::setw(12) << "max"    << "\n";
+    // Saturated = the schedule could not be kept, or the median request is
+    // queueing (p50 an order of magnitude above the lightest step's p50).
+    uint64_t base_p50 = 0;
+    for (double rate : rates) {
+        if (rate <= 0) continue;
+        auto r = runOpenLoopStep(cfg, rate, targets, keys, values, spec.read);
+        double achieved = static_cast<double>(r.ops) / (r.wall.count() / 1e9);
+        const auto& h = r.hist;
+        recordRow("open-loop@" + std::to_string(static_cast<uint64_t>(rate)), cfg.threads, r);
+        if (base_p50 == 0) base_p50 = std::max<uint64_t>(1, h.percentile(0.50));
+        bool saturated = achieved < 0.95 * rate || h.percentile(0.50) > 10 * base_p50;
+        std::cout << std::fixed << std::setprecision(0)
+                  << "  " << std::setw(12) << rate << std::setw(12) << achieved
+                  << " " << std::setw(11) << h.percentile(0.50) << " " << std::setw(11) << h.percentile(0.90)
+                  << " " << std::setw(11) << h.percentile(0.99) << " " << std::setw(11) << h.percentile(0.999)
+                  << " " << std::setw(11) << h.max()
+                  << (saturated ? "  \033[31m← saturated\033[0m" : "") << "\n";
+    }
+}
+
+// ─── Memory footprint ────────────────────────────────────────────────────────
+
+/**
+ * Fills a fresh KVStore with `records` keys of the configured sizes and
+ * measures how much memory it took. The store is created after the
+ * baseline, so its bucket array (reserved up front) is counted. Keys are
+ * built in a reused buffer and values come from a pre-allocated pool, so
+ * only memory the store itself holds shows up in the delta. With TTLs,
+ * every key also gets a node in TTLManager's deadline index.
+ *
+ * SlabPool slabs are mapped outside the malloc heap and kept for the whole
+ * process, so a mix can be served from slabs an earlier mix filled and
+ * freed. The heap delta therefore adds the slab bytes handed out, and the
+ * RSS delta subtracts the change in free slab bytes: each slab object
+ * counts at its class size, whoever mapped the slab.
+ */
+// Slab bytes handed out, and reserved but not handed out.
+static std::pair<double, double> slabBytes() {
+    double used = 0, free = 0;
+    for (auto& c : SlabPool::instance().stats()) {
+        used += static_cast<double>(c.in_use * c.size);
+        free += static_cast<double>(c.reserved - c.in_use * c.size);
+    }
+    return {used, free};
+}
+
+static void runMemoryMix(const BenchConfig& cfg, size_t key_min, size_t key_max,
+                         size_t value_min, size_t value_max, bool with_ttl) {
+    ValuePool    values(value_min, value_max);
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<size_t> key_len(key_min, std::max(key_min, key_max));
+    std::string  key;
+    key.reserve(std::max(key_max, size_t(32)));
+
+    releaseFreeHeap();
+    long      rss0   = processRssKb();
+    long long heap0  = heapInUseBytes();
+    auto      slab0  = slabBytes();
+
+    double payload = 0;
+    {
+        KVStore store(cfg.records);
+        for (size_t i = 0; i < cfg.records; ++i) {
+            key = std::to_string(i);                       // unique prefix
+            size_t len = key_len(rng);
+            if (key.size() < len) key.append(len - key.size(), 'k');
+            const std::string& value = values.pick(rng);
+            payload += static_cast<double>(key.size() + value.size());
+            if (with_ttl) store.set(key, value, 3600);
+            else          store.set(key, value);
+        }
+
+        long      rss1   = processRssKb();
+        long long heap1  = heapInUseBytes();
+        auto      slab1  = slabBytes();
+
+        auto range = [](size_t lo, size_t hi) {
+            return hi > lo ? std::to_string(lo) + "-" + std::to_string(hi) : std::to_string(lo);
+        };
+        MemoryRow row;
+        row.phase = "memory/k" + range(key_min, key_max) + "-v" + range(value_min, value_max)
+                  + (with_ttl ? "+ttl" : "");
+        row.records       = store.size();
+        row.payload_bytes = payload;
+        row.rss_delta     = static_cast<double>(rss1 - rss0) * 1024.0 - (slab1.second - slab0.second);
+        row.heap_delta    = heap0 < 0 ? -1
+                          : static_cast<double>(heap1 - heap0) + (slab1.first - slab0.first);
+        row.used_memory   = static_cast<double>(store.usedMemory());
+        g_memory.push_back(row);
+
+        double n = static_cast<double>(row.records ? row.records : 1);
+        std::cout << std::fixed << std::setprecision(1)
+                  << "  " << std::setw(26) << std::left << row.phase << std::right
+                  << std::setw(10) << row.rss_delta / (1024.0 * 1024.0)
+                  << std::setw(10) << (row.heap_delta < 0 ? 0.0 : row.heap_delta / (1024.0 * 1024.0))
+                  << std::setw(11) << payload / n
+                  << std::setw(11) << (row.heap_delta < 0 ? row.rss_delta : row.heap_delta) / n
+                  << std::setw(11) << ((row.heap_delta < 0 ? row.rss_delta : row.heap_delta) - payload) / n
+                  << std::setw(11) << row.used_memory / n
+                  << "\n";
+    }
+}
+
+// ─── Hit-ratio mode ──────────────────────────────────────────────────────────
+
+struct Access {
+    uint32_t id;
+    bool     counted; // false for scan reads: they'd miss under any policy
+};
+
+struct Trace {
+    std::string              name;
+    std::vector<Access>      accesses;
+    std::vector<std::string> keys;         // recorded traces only; synthetic ones share "user<N>"
+    size_t                   capacity = 0; // 0 = the run's capacity
+};
+
+static std::vector<Trace> syntheticTraces(size_t records, size_t capacity) {
+    const size_t length = 10 * records;
+    std::mt19937 rng(42);
+    ZipfianGenerator zipf(records);
+    auto zipfRead = [&] { return Access{static_cast<uint32_t>(zipf.next(rng)), true}; };
+
+    std::vector<Trace> traces(4);
+    traces[0].name = "zipfian";
+    traces[0].accesses.reserve(length);
+    for (size_t i = 0; i < length; ++i) traces[0].accesses.push_back(zipfRead());
+
+    // The nightly job: every key read once, three times across the day.
+    traces[1].name = "zipf+scan";
+    traces[1].accesses.reserve(length + 3 * records);
+    for (size_t i = 0; i < length; ++i) {
+        if (i > 0 && i % (length / 4) == 0)
+            for (size_t k = 0; k < records; ++k)
+                traces[1].accesses.push_back({static_cast<uint32_t>(k), false});
+        traces[1].accesses.push_back(zipfRead());
+    }
+
+    const size_t loop = std::min(records, capacity + capacity / 2);
+    traces[2].name = "loop";
+    traces[2].accesses.reserve(length);
+    for (size_t i = 0; i < length; ++i)
+        traces[2].accesses.push_back({static_cast<uint32_t>(i % loop), true});
+
+    // The workload changes character every quarter: frequency-skewed, then
+    // recency-driven (a hot window of half the capacity sliding over fresh
+    // keys), then a loop larger than the cache, then skewed again. A policy
+    // tuned for one phase pays in the next.
+    traces[3].name = "shifting";
+    traces[3].accesses.reserve(length);
+    const size_t window = std::max<size_t>(1, capacity / 2);
+    for (size_t i = 0; i < length; ++i) {
+        size_t id;
+        switch (4 * i / length) {
+            case 1:  id = (i / 4 + rng() % window) % records; break;
+            case 2:  id = i % loop;                           break;
+            default: id = zipf.next(rng);                     break;
+        }
+        traces[3].accesses.push_back({static_cast<uint32_t>(id), true});
+    }
+    return traces;
+}
+
+// One access per line: the key is the first field, or the second when the
+// first is a command (GET user42, SET user42 …). Blank lines and '#'
+// comments are skipped. Capacity defaults to a tenth of the distinct keys.
+// @throws std::runtime_error if the file can't be read or has no accesses.
+static Trace loadTrace(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open trace " + path);
+
+    Trace t;
+    t.name = path.substr(path.find_last_of('/') + 1);
+    std::unordered_map<std::string, uint32_t> ids;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key) || key[0] == '#') continue;
+        std::string verb = key;
+        std::transform(verb.begin(), verb.end(), verb.begin(), ::toupper);
+        if (verb == "GET" || verb == "SET" || verb == "GETS" || verb == "DEL") {
+            if (!(fields >> key)) continue;
+        }
+        auto [it, fresh] = ids.emplace(key, static_cast<uint32_t>(t.keys.size()));
+        if (fresh) t.keys.push_back(key);
+        t.accesses.push_back({it->second, true});
+    }
+    if (t.accesses.empty()) throw std::runtime_error("trace " + path + " has no accesses");
+    t.capacity = std::max<size_t>(1, t.keys.size() / 10);
+    return t;
+}
+
+// Cache-aside replay: GET, and SET on a miss. Returns the counted hit ratio.
+static double replay(const Trace& trace, const std::vector<std::string>& keys,
+                     size_t capacity, EvictionPolicy policy) {
+    KVStore store(capacity, 0, policy);
+    const std::string value(16, 'v');
+    uint64_t hits = 0, counted = 0;
+    for (const Access& a : trace.accesses) {
+        const std::string& k = keys[a.id];
+        bool hit = store.get(k).has_value();
+        if (!hit) store.set(k, value);
+        if (a.counted) { ++counted; hits += hit; }
+    }
+    return counted ? static_cast<double>(hits) / static_cast<double>(counted) : 0.0;
+}
+
+static void runHitRatio(const BenchConfig& cfg) {
+    const size_t records  = cfg.records;
+    const size_t capacity = cfg.capacity ? cfg.capacity : std::max<size_t>(1, records / 10);
+    auto policies = parsePolicies(cfg.policies, {std::begin(ALL_EVICTION_POLICIES),
+                                                 std::end(ALL_EVICTION_POLICIES)});
+
+    std::vector<Trace> traces;
+    for (const auto& path : cfg.traces) {
+        traces.push_back(loadTrace(path));
+        if (cfg.capacity) traces.back().capacity = cfg.capacity;
+    }
+    std::vector<std::string> keys;
+    if (traces.empty()) {
+        printHeader("Hit ratio: " + std::to_string(records) + " keys, capacity "
+                    + std::to_string(capacity));
+        keys.reserve(records);
+        for (size_t i = 0; i < records; ++i) keys.push_back("user" + std::to_string(i));
+        traces = syntheticTraces(records, capacity);
+    } else {
+        printHeader("Hit ratio: " + std::to_string(traces.size()) + " recorded trace(s)");
+    }
+
+    std::cout << "  " << std::setw(12) << std::left << "trace" << std::right
+              << std::setw(10) << "capacity";
+    for (auto p : policies) std::cout << std::setw(10) << evictionPolicyName(p);
+    std::cout << "\n";
+    for (const auto& t : traces) {
+        const size_t cap = t.capacity ? t.capacity : capacity;
+        std::cout << "  " << std::setw(12) << std::left << t.name << std::right
+                  << std::setw(10) << cap << std::flush;
+        for (auto p : policies) {
+            double ratio = replay(t, t.keys.empty() ? keys : t.keys, cap, p);
+            g_hit_ratio.push_back({"hit-ratio/" + t.name + "/" + evictionPolicyName(p),
+                                   t.accesses.size(), ratio});
+            std::cout << std::setw(9) << std::fixed << std::setprecision(1)
+                      << 100.0 * ratio << "%" << std::flush;
+        }
+        std::cout << "\n";
+    }
+}
+
+static void runMemory(const BenchConfig& cfg) {
+    printHeader("Memory footprint: " + std::to_string(cfg.records) + " keys per mix");
+    std::cout << "  " << std::setw(26) << std::left << "mix" << std::right
+              << std::setw(10) << "RSS MiB" << std::setw(10) << "heap MiB"
+              << std::setw(11) << "payload/k" << std::setw(11) << "bytes/k"
+              << std::setw(11) << "overhead/k" << std::setw(11) << "used_mem/k" << "\n";
+    if (heapInUseBytes() < 0)
+        std::cout << "  \033[90m  (allocator statistics unavailable — per-key figures use RSS)\033[0m\n";
+
+    struct Mix { size_t kmin, kmax, vmin, vmax; };
+    std::vector<Mix> mixes;
+    if (cfg.sizes_given)
+        mixes.push_back({cfg.key_min, cfg.key_max, cfg.value_min, cfg.value_max});
+    else
+        mixes = {{8, 8, 8, 8},          // both fit in the small-string buffer
+                 {16, 16, 100, 100},    // typical session / cache entry
+                 {24, 48, 16, 256},     // mixed, small values
+                 {32, 32, 1024, 1024},  // value-dominated
+                 {16, 64, 64, 4096}};   // wide spread
+
+    for (const auto& m : mixes)
+        for (bool ttl : {false, true})
+            runMemoryMix(cfg, m.kmin, m.kmax, m.vmin, m.vmax, ttl);
+    std::cout << "  \033[90m  overhead/k = allocated bytes per key beyond the key + value "
+                 "payload (nodes, index, TTL index)\033[0m\n";
+    std::cout << "  \033[90m  used_mem/k = the store's own accounting (STATS used_memory), "
+                 "which drives --maxmemory\033[0m\n";
 }
 
 // ─── Benchmark cases ─────────────────────────────────────────────────────────
 
-static constexpr size_t N           = 100'000;
-static constexpr size_t BENCH_CAP   = 200'000; // large enough to avoid eviction in write test
+// Throwaway mixed load on a scratch store: warms caches, the allocator and
+// CPU frequency so the first measured phase isn't penalised.
+static void warmUp(const BenchConfig& cfg) {
+    BenchConfig w = cfg;
+    w.duration_s  = cfg.warmup_s;
+    KVStore scratch(BENCH_CAP);
+    runPhase(w, 0, [&](size_t i, std::mt19937& rng) {
+        std::string k = "warm:" + std::to_string(std::uniform_int_distribution<size_t>(0, N - 1)(rng));
+        if (i % 4 == 0) scratch.set(k, k);
+        return scratch.get(k).has_value();
+    });
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg = parseArgs(argc, argv);
+
+    // Machine formats own stdout: silence the human-readable output.
+    std::ostream report_out(std::cout.rdbuf());
+    if (cfg.format != "text") std::cout.rdbuf(nullptr);
+
+    if (!cfg.pin.empty() && !pinToCpus(cfg.pin))
+        std::cerr << "  [WARN] could not pin to CPUs " << cfg.pin << "\n";
+    if (cfg.warmup_s > 0) warmUp(cfg);
+
+    PerfCounters perf;
+    if (cfg.perf) {
+        if (perf.open()) g_perf = &perf;
+        if (!perf.error().empty())
+            std::cerr << "  [WARN] some counters unavailable (" << perf.error()
+                      << "); check /proc/sys/kernel/perf_event_paranoid\n";
+    }
 
-int main() {
     std::cout << "\033[1;35m\n";
     std::cout << "   ██████╗ ███████╗███╗   ██╗ ██████╗██╗  ██╗\n";
     std::cout << "   ██╔══██╗██╔════╝████╗  ██║██╔════╝██║  ██║\n";
@@ -59,48 +1181,93 @@ int main() {
     std::cout << "   ██████╔╝███████╗██║ ╚████║╚██████╗██║  ██║\n";
     std::cout << "   ╚═════╝ ╚══════╝╚═╝  ╚═══╝ ╚═════╝╚═╝  ╚═╝\n";
     std::cout << "\033[0m";
-    std::cout << "  ChronoStore Throughput Benchmark — " << N / 1000 << "k ops per phase\n";
+    std::cout << "  ChronoStore Throughput Benchmark — ";
+    if (cfg.duration_s > 0) std::cout << cfg.duration_s << "s";
+    else                    std::cout << cfg.ops / 1000 << "k ops";
+    std::cout << " per phase, " << cfg.threads << " thread(s)\n";
+
+    if (cfg.memory) {
+        runMemory(cfg);
+        std::cout << "\n";
+        writeReport(report_out, cfg.format);
+        return 0;
+    }
+
+    if (cfg.hit_ratio) {
+        try {
+            runHitRatio(cfg);
+        } catch (const std::exception& ex) {
+            std::cerr << "\033[31m  (error) " << ex.what() << "\033[0m\n";
+            return 1;
+        }
+        std::cout << "\n";
+        writeReport(report_out, cfg.format);
+        return 0;
+    }
+
+    if (!cfg.open_loop.empty()) {
+        try {
+            runOpenLoop(cfg);
+        } catch (const std::exception& ex) {
+            std::cerr << "\033[31m  (error) " << ex.what() << "\033[0m\n";
+            return 1;
+        }
+        std::cout << "\n";
+        writeReport(report_out, cfg.format);
+        return 0;
+    }
+
+    if (!cfg.workloads.empty()) {
+        try {
+            auto policies = parsePolicies(cfg.policies, {EvictionPolicy::LRU});
+            for (char w : cfg.workloads)
+                for (auto p : policies)
+                    runYcsb(cfg, ycsbWorkload(w), p,
+                            policies.size() > 1 ? std::string("@") + evictionPolicyName(p) : "");
+        } catch (const std::exception& ex) {
+            std::cerr << "\033[31m  (error) " << ex.what() << "\033[0m\n";
+            return 1;
+        }
+        std::cout << "\n";
+        writeReport(report_out, cfg.format);
+        return 0;
+    }
+
+    const size_t n = cfg.ops;
 
     // ── 1. WRITE benchmark ────────────────────────────────────────────────────
     printHeader("Phase 1: Sequential WRITE (SET)");
 
     KVStore write_store(BENCH_CAP);
+    size_t  written = 0;
     {
-        auto   start = hrc::now();
-        for (size_t i = 0; i < N; ++i) {
+        auto r = runPhase(cfg, n, [&](size_t i, std::mt19937&) {
             write_store.set("key:" + std::to_string(i), "value:" + std::to_string(i));
-        }
-        auto dur = hrc::now() - start;
-        printResult("Sequential SET", N, dur);
+            return true;
+        });
+        printResult("Sequential SET", r, cfg.threads);
+        written = std::max<size_t>(1, r.ops);
     }
 
     // ── 2. SEQUENTIAL READ (all hits) ─────────────────────────────────────────
     printHeader("Phase 2: Sequential READ (all hits)");
     {
-        auto start = hrc::now();
-        size_t hits = 0;
-        for (size_t i = 0; i < N; ++i) {
-            if (write_store.get("key:" + std::to_string(i))) ++hits;
-        }
-        auto dur = hrc::now() - start;
-        printResult("Sequential GET", N, dur);
-        std::cout << "  \033[90m  → " << hits << "/" << N << " hits\033[0m\n";
+        auto r = runPhase(cfg, n, [&](size_t i, std::mt19937&) {
+            return write_store.get("key:" + std::to_string(i % written)).has_value();
+        });
+        printResult("Sequential GET", r, cfg.threads);
+        std::cout << "  \033[90m  → " << r.hits << "/" << r.ops << " hits\033[0m\n";
     }
 
     // ── 3. RANDOM READ (~50% hit) ─────────────────────────────────────────────
     printHeader("Phase 3: Random READ (~50% hit rate)");
     {
-        std::mt19937 rng(42);
-        std::uniform_int_distribution<size_t> dist(0, N * 2 - 1); // keys 0..(2N-1)
-
-        auto   start = hrc::now();
-        size_t hits  = 0;
-        for (size_t i = 0; i < N; ++i) {
-            if (write_store.get("key:" + std::to_string(dist(rng)))) ++hits;
-        }
-        auto dur = hrc::now() - start;
-        printResult("Random GET", N, dur);
-        double hr = 100.0 * hits / N;
+        auto r = runPhase(cfg, n, [&](size_t, std::mt19937& rng) {
+            std::uniform_int_distribution<size_t> dist(0, written * 2 - 1); // keys 0..(2W-1)
+            return write_store.get("key:" + std::to_string(dist(rng))).has_value();
+        });
+        printResult("Random GET", r, cfg.threads);
+        double hr = 100.0 * static_cast<double>(r.hits) / static_cast<double>(r.ops);
         std::cout << "  \033[90m  → " << std::fixed << std::setprecision(1)
                   << hr << "% hit rate\033[0m\n";
     }
@@ -108,47 +1275,42 @@ int main() {
     // ── 4. MIXED READ/WRITE (70/30) ───────────────────────────────────────────
     printHeader("Phase 4: Mixed R/W (70% GET, 30% SET)");
     {
-        std::mt19937 rng2(123);
-        std::uniform_int_distribution<size_t> key_dist(0, N - 1);
-        std::uniform_int_distribution<int>    op_dist(1, 10);
-
-        auto   start = hrc::now();
-        for (size_t i = 0; i < N; ++i) {
-            std::string k = "key:" + std::to_string(key_dist(rng2));
-            if (op_dist(rng2) <= 7) {
+        auto r = runPhase(cfg, n, [&](size_t i, std::mt19937& rng) {
+            std::uniform_int_distribution<size_t> key_dist(0, written - 1);
+            std::uniform_int_distribution<int>    op_dist(1, 10);
+            std::string k = "key:" + std::to_string(key_dist(rng));
+            if (op_dist(rng) <= 7) {
                 write_store.get(k);
             } else {
                 write_store.set(k, "v" + std::to_string(i));
             }
-        }
-        auto dur = hrc::now() - start;
-        printResult("Mixed R/W", N, dur);
+            return true;
+        }, 123);
+        printResult("Mixed R/W", r, cfg.threads);
     }
 
     // ── 5. TTL SET benchmark ──────────────────────────────────────────────────
     printHeader("Phase 5: SET with TTL (EX 3600)");
     {
         KVStore ttl_store(BENCH_CAP);
-        auto   start = hrc::now();
-        for (size_t i = 0; i < N; ++i) {
+        auto r = runPhase(cfg, n, [&](size_t i, std::mt19937&) {
             ttl_store.set("ttlkey:" + std::to_string(i),
                           "val:" + std::to_string(i),
                           3600 /* 1 hour TTL */);
-        }
-        auto dur = hrc::now() - start;
-        printResult("SET with TTL", N, dur);
+            return true;
+        });
+        printResult("SET with TTL", r, cfg.threads);
     }
 
     // ── 6. LRU eviction stress ────────────────────────────────────────────────
-    printHeader("Phase 6: LRU Eviction Stress (cap=1000, write 10k)");
+    printHeader("Phase 6: LRU Eviction Stress (cap=1000)");
     {
         KVStore evict_store(1000);
-        auto   start = hrc::now();
-        for (size_t i = 0; i < 10'000; ++i) {
+        auto r = runPhase(cfg, std::max<size_t>(n / 10, 1), [&](size_t i, std::mt19937&) {
             evict_store.set("ek:" + std::to_string(i), std::to_string(i));
-        }
-        auto dur = hrc::now() - start;
-        printResult("SET (evicting)", 10'000, dur);
+            return true;
+        });
+        printResult("SET (evicting)", r, cfg.threads);
         auto s = evict_store.stats();
         std::cout << "  \033[90m  → " << s.evictions << " evictions, "
                   << s.current_keys << " keys remain\033[0m\n";
@@ -163,7 +1325,9 @@ int main() {
     std::cout << "  Hit ratio :   " << std::fixed << std::setprecision(1)
               << (s.hits + s.misses > 0 ? 100.0 * static_cast<double>(s.hits) / static_cast<double>(s.hits + s.misses) : 0.0)
               << "%\n";
+    printLocks(s);
     std::cout << "\033[1;36m  ==============================================\033[0m\n\n";
 
+    writeReport(report_out, cfg.format);
     return 0;
 }
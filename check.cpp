@@ -0,0 +1,290 @@
+/**
+ * check.cpp — regression checks for KVStore and its parts
+ *
+ * Each check replays a short, deterministic sequence against the store,
+ * the command parser or the slab pool and verifies the observable state.
+ * Exit status is 0 when every check passes and 1 otherwise.
+ *
+ * Compile / run:
+ *   make check
+ */
+#include "command_parser.h"
+#include "slab_allocator.h"
+#include "store.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int g_failures = 0;
+
+static void expect(bool ok, const std::string& what) {
+    std::cout << (ok ? "  ok    " : "  FAIL  ") << what << "\n";
+    if (!ok) ++g_failures;
+}
+
+// volatile-*: only keys with a TTL are evicted while any exist; then the
+// store falls back to the cache's own order (the capacity is hard).
+static void volatilePolicies() {
+    for (auto policy : {MaxmemoryPolicy::VOLATILE_LRU, MaxmemoryPolicy::VOLATILE_RANDOM,
+                        MaxmemoryPolicy::VOLATILE_TTL}) {
+        const std::string name = maxmemoryPolicyName(policy);
+        KVStore s(4, 0, EvictionPolicy::LRU, policy);
+        s.set("p1", "1");
+        s.set("p2", "1");
+        s.set("t1", "1", 100);
+        s.set("t2", "1", 50);
+        const std::string first  = s.set("n1", "1");
+        const std::string second = s.set("n2", "1");
+        expect((first == "t1" || first == "t2") && (second == "t1" || second == "t2"),
+               name + ": evicts the keys with a TTL first");
+        if (policy == MaxmemoryPolicy::VOLATILE_TTL)
+            expect(first == "t2", name + ": soonest deadline first");
+        expect(s.set("n3", "1") == "p1", name + ": no TTL left, falls back to LRU order");
+        expect(s.get("p2").has_value() && s.size() == 4, name + ": only one key per write is evicted");
+    }
+}
+
+// SIEVE: the hand starts at the tail and moves toward the head, clearing
+// visited bits as it passes and evicting the first unvisited entry; it
+// stays where it stopped for the next eviction.
+static void sieveVictimOrder() {
+    LRUCache c(3, EvictionPolicy::SIEVE);
+    c.set("a", "1");
+    c.set("b", "1");
+    c.set("c", "1");
+    c.get("a");
+    expect(c.set("d", "1") == "b", "sieve: the hand passes visited a, evicts b");
+    expect(c.set("e", "1") == "c", "sieve: the hand resumes at c");
+    expect(c.set("f", "1") == "d", "sieve: then d");
+    c.get("e");
+    expect(c.set("g", "1") == "f", "sieve: passes visited e, evicts f");
+    expect(c.contains("a") && c.contains("e"), "sieve: visited entries survive");
+}
+
+// W-TinyLFU: a scan of keys seen once must not flush keys that are hot in
+// the frequency sketch; plain LRU loses all of them.
+static void tinyLfuScanResistance() {
+    auto hotSurvivors = [](EvictionPolicy policy) {
+        LRUCache c(100, policy);
+        for (int i = 0; i < 100; ++i) c.set("h" + std::to_string(i), "1");
+        for (int round = 0; round < 5; ++round)
+            for (int i = 0; i < 100; ++i) c.get("h" + std::to_string(i));
+        for (int i = 0; i < 1000; ++i) c.set("s" + std::to_string(i), "1");
+        int hot = 0;
+        for (int i = 0; i < 100; ++i) hot += c.contains("h" + std::to_string(i));
+        return hot;
+    };
+    expect(hotSurvivors(EvictionPolicy::TINYLFU) >= 90, "tinylfu: hot keys survive a scan");
+    expect(hotSurvivors(EvictionPolicy::LRU) == 0,      "tinylfu: (lru loses them all)");
+}
+
+// FLUSH and FLUSH ASYNC drop TTLs with the keys: a flushed key is gone
+// (-2), and writing it again does not bring its old TTL back (-1).
+static void flushClearsTtls() {
+    for (bool async : {false, true}) {
+        const std::string name = async ? "flush async" : "flush";
+        KVStore s;
+        s.set("k", "1", 100);
+        s.flush(async);
+        expect(s.ttl("k") == -2, name + ": TTL of a flushed key is -2");
+        s.set("k", "2");
+        expect(s.ttl("k") == -1, name + ": the key set again has no TTL");
+    }
+}
+
+// Batch eviction spares the entry written last under every policy, even
+// after reads have aged it to the LRU end (background reclaim runs after
+// the write, with GETs in between).
+static void evictionSparesNewest() {
+    for (auto policy : {EvictionPolicy::LRU, EvictionPolicy::TINYLFU,
+                        EvictionPolicy::ARC, EvictionPolicy::SIEVE}) {
+        const std::string name = evictionPolicyName(policy);
+        LRUCache c(LRUCache::UNLIMITED, policy);
+        for (int i = 0; i < 8; ++i) c.set("k" + std::to_string(i), "1");
+        c.set("k3", "2");
+        for (int round = 0; round < 3; ++round)
+            for (int i = 0; i < 8; ++i)
+                if (i != 3) c.get("k" + std::to_string(i));
+        c.evictKeys(7);
+        expect(c.size() == 1 && c.contains("k3"), name + ": the key written last survives");
+    }
+}
+
+// True if the parser refuses `line` as malformed.
+static bool rejects(const std::string& line) {
+    try { CommandParser().parse(line); } catch (const std::invalid_argument&) { return true; }
+    return false;
+}
+
+// ARC: a SET whose key is still on a ghost list starts on T2, not at the
+// front of T1. The TTL must land on that key, not on T1's newest entry.
+static void arcGhostHitTtl() {
+    KVStore s(2, 0, EvictionPolicy::ARC);
+    s.set("a", "1");
+    s.set("b", "1");
+    s.get("a");           // a → T2
+    s.set("c", "1");      // evicts b from T1; b's hash joins B1
+    s.set("b", "2", 100); // B1 ghost hit: b starts on T2
+    expect(s.get("b") == std::optional<std::string>("2"), "arc ghost hit: b stored");
+    expect(s.ttl("b") > 0,                                "arc ghost hit: TTL on b");
+    expect(s.ttl("c") < 0,                                "arc ghost hit: no TTL on c");
+}
+
+// ARC under maxmemory: a value larger than the limit makes one batch evict
+// T1 down to the entry just written, its only entry. That entry must
+// survive, with the older T2 key evicted instead.
+static void arcKeepsNewest() {
+    KVStore s(LRUCache::UNLIMITED, 64 * 1024, EvictionPolicy::ARC);
+    s.set("a", "1");
+    s.get("a"); // a → T2
+    for (int i = 0; i < 4; ++i) s.set("k" + std::to_string(i), "1");
+    s.set("big", std::string(100 * 1024, 'x'));
+    expect(s.get("big").has_value(), "arc: the key just written survives");
+    expect(s.size() == 1,            "arc: everything else is evicted");
+}
+
+// CAS options: a dangling or non-numeric EX is a syntax error, not a CAS
+// without a TTL.
+static void casRejectsBadEx() {
+    CommandParser parser;
+    expect(rejects("CAS k v 5 EX"),     "cas: EX without seconds is rejected");
+    expect(rejects("CAS k v 5 EX abc"), "cas: non-numeric EX is rejected");
+    expect(rejects("CAS k v 5 PX 10"),  "cas: unknown option is rejected");
+    expect(parser.parse("CAS k v 5 ex 10").ttl == 10, "cas: EX sets the TTL");
+}
+
+// EX takes a whole number of seconds; a unit suffix or trailing junk is an
+// error, on SET and on CAS alike.
+static void exRejectsTrailingJunk() {
+    CommandParser parser;
+    expect(rejects("SET k v EX 10abc"),  "ex: trailing junk is rejected");
+    expect(rejects("SET k v EX 5s"),     "ex: a unit suffix is rejected");
+    expect(rejects("CAS k v 5 EX 5s"),   "ex: a unit suffix is rejected on CAS");
+    expect(parser.parse("SET k v EX 5").ttl == 5, "ex: plain seconds parse");
+}
+
+// SLOWLOG GET takes a plain count.
+static void slowlogRejectsBadCount() {
+    CommandParser parser;
+    expect(rejects("SLOWLOG GET 5x"),  "slowlog: trailing junk is rejected");
+    expect(rejects("SLOWLOG GET -1"),  "slowlog: a negative count is rejected");
+    expect(parser.parse("SLOWLOG GET 5").delta == 5, "slowlog: count parses");
+}
+
+// Objects of `bytes`'s class handed out, pool-wide.
+static size_t slabInUse(size_t bytes) {
+    const size_t size = SlabPool::classSize(SlabPool::classOf(bytes));
+    for (auto& c : SlabPool::instance().stats()) if (c.size == size) return c.in_use;
+    return 0;
+}
+
+static size_t slabReserved(size_t bytes) {
+    const size_t size = SlabPool::classSize(SlabPool::classOf(bytes));
+    for (auto& c : SlabPool::instance().stats()) if (c.size == size) return c.reserved;
+    return 0;
+}
+
+static uintptr_t slabAddress(const void* p) {
+    return reinterpret_cast<uintptr_t>(p) & ~uintptr_t(SlabPool::SLAB_BYTES - 1);
+}
+
+// SlabPool size classes: each size fits its class, past 128 bytes with at
+// most 12.5% rounding; objects are 16-byte aligned and never overlap.
+static void slabSizeClasses() {
+    bool fits = true;
+    for (size_t n = 1; n <= SlabPool::MAX_SIZE; ++n) {
+        const size_t c = SlabPool::classSize(SlabPool::classOf(n));
+        if (c < n || c % 16 || (n > 128 && c - n > n / 8)) fits = false;
+    }
+    expect(fits, "slab: every size fits its class with at most 12.5% waste");
+
+    SlabPool& pool = SlabPool::instance();
+    bool intact = true, aligned = true, counted = true;
+    for (size_t bytes : {8, 24, 100, 200, 1000, 3000, 8192}) {
+        const size_t base = slabInUse(bytes);
+        std::vector<void*> objs(500);
+        for (size_t i = 0; i < objs.size(); ++i) {
+            objs[i] = pool.allocate(bytes);
+            std::memset(objs[i], static_cast<int>(i & 0xff), bytes);
+            if (reinterpret_cast<uintptr_t>(objs[i]) % 16) aligned = false;
+        }
+        if (slabInUse(bytes) != base + objs.size()) counted = false;
+        for (size_t i = 0; i < objs.size(); ++i) {
+            const auto* b = static_cast<const unsigned char*>(objs[i]);
+            if (b[0] != (i & 0xff) || b[bytes - 1] != (i & 0xff)) intact = false;
+            pool.deallocate(objs[i], bytes);
+        }
+        if (slabInUse(bytes) != base) counted = false;
+    }
+    expect(aligned, "slab: objects are 16-byte aligned");
+    expect(intact,  "slab: objects of a class do not overlap");
+    expect(counted, "slab: in-use counts follow allocate and free");
+}
+
+// An object freed on another thread goes back to its class and is reused.
+static void slabCrossThreadFree() {
+    SlabPool& pool = SlabPool::instance();
+    const size_t bytes = 200, base = slabInUse(bytes);
+    std::vector<void*> objs(1000);
+    std::thread([&] { for (auto& p : objs) p = pool.allocate(bytes); }).join();
+    const size_t reserved = slabReserved(bytes);
+    std::thread([&] { for (auto p : objs) pool.deallocate(p, bytes); }).join();
+    expect(slabInUse(bytes) == base, "slab: objects freed on another thread are returned");
+    std::thread([&] { for (auto& p : objs) p = pool.allocate(bytes); }).join();
+    expect(slabReserved(bytes) == reserved, "slab: and reused without new slabs");
+    for (auto p : objs) pool.deallocate(p, bytes);
+}
+
+// A defrag cycle releases slabs with no live object; a released slab can
+// then serve a different class.
+static void slabReleaseAndReuse() {
+    SlabPool& pool = SlabPool::instance();
+    std::set<uintptr_t> slabs;
+    std::thread([&] { // exits, so its cached objects go back to the class
+        std::vector<void*> objs(5 * SlabPool::SLAB_BYTES / 1000);
+        for (auto& p : objs) p = pool.allocate(1000);
+        for (auto p : objs) { slabs.insert(slabAddress(p)); pool.deallocate(p, 1000); }
+    }).join();
+    const size_t released = pool.releasedBytes();
+    if (pool.beginDefrag()) pool.endDefrag();
+    expect(pool.releasedBytes() >= released + (slabs.size() - 1) * SlabPool::SLAB_BYTES,
+           "slab: empty slabs are released (all but the current one)");
+
+    // Enough objects of a fresh class to take up every slab just released.
+    const size_t freed = (pool.releasedBytes() - released) / SlabPool::SLAB_BYTES;
+    std::vector<void*> objs((freed + 1) * (SlabPool::SLAB_BYTES / 5000));
+    bool reused = false;
+    for (auto& p : objs) {
+        p = pool.allocate(5000);
+        reused |= slabs.count(slabAddress(p)) > 0;
+    }
+    expect(reused, "slab: a released slab serves another class");
+    for (auto p : objs) pool.deallocate(p, 5000);
+}
+
+int main() {
+    arcGhostHitTtl();
+    arcKeepsNewest();
+    casRejectsBadEx();
+    exRejectsTrailingJunk();
+    slowlogRejectsBadCount();
+    slabSizeClasses();
+    slabCrossThreadFree();
+    slabReleaseAndReuse();
+    volatilePolicies();
+    sieveVictimOrder();
+    tinyLfuScanResistance();
+    flushClearsTtls();
+    evictionSparesNewest();
+    if (g_failures) {
+        std::cout << g_failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "all checks passed\n";
+    return 0;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <algorithm>
+#include <cstdint>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -11,8 +12,18 @@
 enum class CommandType {
     SET,
     GET,
+    GETS,
+    CAS,
     DEL,
+    MGET,
+    MSET,
+    MDEL,
+    UNLINK,
+    INCR,
     STATS,
+    INFO,
+    LATENCY,
+    SLOWLOG,
     SAVE,
     TTL,
     KEYS,
@@ -27,13 +38,30 @@ enum class CommandType {
  * Examples:
  *   SET name Bhanu          → type=SET, key="name", value="Bhanu", ttl=-1
  *   SET name Bhanu EX 30    → type=SET, key="name", value="Bhanu", ttl=30
+ *   SET lock me NX EX 10    → type=SET, ..., nx=true, ttl=10
+ *   SET name Bhanu XX GET   → type=SET, ..., xx=true, get_old=true
+ *   GETSET name Bhanu       → type=SET, ..., get_old=true
  *   GET name                → type=GET, key="name"
+ *   GETS name               → type=GETS, key="name" (value + CAS version)
+ *   CAS name Bhanu 17       → type=CAS, key="name", value="Bhanu", version=17
  *   DEL name                → type=DEL, key="name"
+ *   MGET a b c              → type=MGET, args={"a","b","c"}
+ *   MSET a 1 b 2            → type=MSET, args={"a","1","b","2"}
+ *   MDEL a b                → type=MDEL, args={"a","b"}
+ *   UNLINK a b              → type=UNLINK, args={"a","b"} (free in background)
  *   STATS                   → type=STATS
+ *   INFO [stats|latency|slabs] → type=INFO, key="stats"/"latency"/"slabs" ("" = all)
+ *   LATENCY                 → type=LATENCY (per-command percentiles)
+ *   LATENCY RESET           → type=LATENCY, key="RESET"
+ *   SLOWLOG GET [n]         → type=SLOWLOG, key="GET", delta=n (default 10)
+ *   SLOWLOG LEN | RESET     → type=SLOWLOG, key="LEN" / "RESET"
  *   SAVE                    → type=SAVE
+ *   INCR hits               → type=INCR, key="hits", delta=1
+ *   DECR hits               → type=INCR, key="hits", delta=-1
+ *   INCRBY hits 10          → type=INCR, key="hits", delta=10
  *   TTL name                → type=TTL, key="name"
  *   KEYS                    → type=KEYS (list all keys)
- *   FLUSH                   → type=FLUSH (clear all keys)
+ *   FLUSH [ASYNC|SYNC]      → type=FLUSH, key="ASYNC"/"SYNC"/"" (clear all keys)
  *   EXIT                    → type=EXIT
  */
 struct Command {
@@ -41,6 +69,13 @@ struct Command {
     std::string key;
     std::string value;
     long long   ttl   = -1; // seconds; -1 means no expiry
+    long long   delta = 1;  // INCR / DECR / INCRBY amount
+    uint64_t    version = 0; // CAS token from GETS
+    bool        nx       = false; // SET ... NX      : only if absent
+    bool        xx       = false; // SET ... XX      : only if present
+    bool        get_old  = false; // SET ... GET     : reply with previous value
+    bool        keep_ttl = false; // SET ... KEEPTTL : retain existing TTL
+    std::vector<std::string> args; // multi-key commands: keys, or key/value pairs for MSET
     std::string raw;        // original input for error messages
 };
 
@@ -62,29 +97,92 @@ public:
         std::string verb = toUpper(tokens[0]);
 
         if (verb == "SET") {
-            if (tokens.size() < 3) {
-                throw std::invalid_argument("Usage: SET <key> <value> [EX <seconds>]");
-            }
+            static const char* usage =
+                "Usage: SET <key> <value> [NX|XX] [GET] [EX <seconds>|KEEPTTL]";
+            if (tokens.size() < 3) throw std::invalid_argument(usage);
             cmd.type  = CommandType::SET;
             cmd.key   = tokens[1];
             cmd.value = tokens[2];
-            // Optional: EX <seconds>
-            if (tokens.size() >= 5 && toUpper(tokens[3]) == "EX") {
-                try {
-                    cmd.ttl = std::stoll(tokens[4]);
-                    if (cmd.ttl <= 0) throw std::invalid_argument("TTL must be positive");
-                } catch (const std::exception&) {
-                    throw std::invalid_argument("Invalid TTL value: " + tokens[4]);
+            // Options may appear in any order
+            for (size_t i = 3; i < tokens.size(); ++i) {
+                std::string opt = toUpper(tokens[i]);
+                if (opt == "EX" && i + 1 < tokens.size()) {
+                    cmd.ttl = parseTtl(tokens[++i]);
+                } else if (opt == "NX") {
+                    cmd.nx = true;
+                } else if (opt == "XX") {
+                    cmd.xx = true;
+                } else if (opt == "GET") {
+                    cmd.get_old = true;
+                } else if (opt == "KEEPTTL") {
+                    cmd.keep_ttl = true;
+                } else {
+                    throw std::invalid_argument(usage);
                 }
             }
-        } else if (verb == "GET") {
-            if (tokens.size() < 2) throw std::invalid_argument("Usage: GET <key>");
-            cmd.type = CommandType::GET;
+            if (cmd.nx && cmd.xx)
+                throw std::invalid_argument("NX and XX options are mutually exclusive");
+            if (cmd.keep_ttl && cmd.ttl > 0)
+                throw std::invalid_argument("EX and KEEPTTL options are mutually exclusive");
+        } else if (verb == "GETSET") {
+            if (tokens.size() < 3) throw std::invalid_argument("Usage: GETSET <key> <value>");
+            cmd.type    = CommandType::SET;
+            cmd.key     = tokens[1];
+            cmd.value   = tokens[2];
+            cmd.get_old = true;
+        } else if (verb == "GET" || verb == "GETS") {
+            if (tokens.size() < 2) throw std::invalid_argument("Usage: " + verb + " <key>");
+            cmd.type = (verb == "GET") ? CommandType::GET : CommandType::GETS;
             cmd.key  = tokens[1];
+        } else if (verb == "CAS") {
+            static const char* usage = "Usage: CAS <key> <value> <version> [EX <seconds>]";
+            if (tokens.size() != 4 && tokens.size() != 6) throw std::invalid_argument(usage);
+            cmd.type  = CommandType::CAS;
+            cmd.key   = tokens[1];
+            cmd.value = tokens[2];
+            try {
+                size_t used = 0;
+                cmd.version = std::stoull(tokens[3], &used);
+                if (used != tokens[3].size() || tokens[3][0] == '-')
+                    throw std::invalid_argument("trailing");
+            } catch (const std::exception&) {
+                throw std::invalid_argument("Invalid CAS version: " + tokens[3]);
+            }
+            if (tokens.size() == 6) {
+                if (toUpper(tokens[4]) != "EX") throw std::invalid_argument(usage);
+                cmd.ttl = parseTtl(tokens[5]);
+            }
         } else if (verb == "DEL" || verb == "DELETE") {
             if (tokens.size() < 2) throw std::invalid_argument("Usage: DEL <key>");
             cmd.type = CommandType::DEL;
             cmd.key  = tokens[1];
+        } else if (verb == "MGET" || verb == "MDEL" || verb == "UNLINK") {
+            if (tokens.size() < 2)
+                throw std::invalid_argument("Usage: " + verb + " <key> [key ...]");
+            cmd.type = (verb == "MGET") ? CommandType::MGET
+                     : (verb == "MDEL") ? CommandType::MDEL : CommandType::UNLINK;
+            cmd.args.assign(tokens.begin() + 1, tokens.end());
+        } else if (verb == "MSET") {
+            if (tokens.size() < 3 || tokens.size() % 2 == 0)
+                throw std::invalid_argument("Usage: MSET <key> <value> [key value ...]");
+            cmd.type = CommandType::MSET;
+            cmd.args.assign(tokens.begin() + 1, tokens.end());
+        } else if (verb == "INCR" || verb == "DECR") {
+            if (tokens.size() < 2) throw std::invalid_argument("Usage: " + verb + " <key>");
+            cmd.type  = CommandType::INCR;
+            cmd.key   = tokens[1];
+            cmd.delta = (verb == "INCR") ? 1 : -1;
+        } else if (verb == "INCRBY") {
+            if (tokens.size() < 3) throw std::invalid_argument("Usage: INCRBY <key> <increment>");
+            cmd.type = CommandType::INCR;
+            cmd.key  = tokens[1];
+            try {
+                size_t used = 0;
+                cmd.delta = std::stoll(tokens[2], &used);
+                if (used != tokens[2].size()) throw std::invalid_argument("trailing");
+            } catch (const std::exception&) {
+                throw std::invalid_argument("Invalid increment: " + tokens[2]);
+            }
         } else if (verb == "TTL") {
             if (tokens.size() < 2) throw std::invalid_argument("Usage: TTL <key>");
             cmd.type = CommandType::TTL;
@@ -93,8 +191,45 @@ public:
             cmd.type = CommandType::KEYS;
         } else if (verb == "FLUSH") {
             cmd.type = CommandType::FLUSH;
+            if (tokens.size() >= 2) {
+                cmd.key = toUpper(tokens[1]);
+                if (cmd.key != "ASYNC" && cmd.key != "SYNC")
+                    throw std::invalid_argument("Usage: FLUSH [ASYNC|SYNC]");
+            }
         } else if (verb == "STATS") {
             cmd.type = CommandType::STATS;
+        } else if (verb == "INFO") {
+            cmd.type = CommandType::INFO;
+            if (tokens.size() >= 2) {
+                cmd.key = toLower(tokens[1]);
+                if (cmd.key == "all") cmd.key.clear();
+                else if (cmd.key != "stats" && cmd.key != "latency" && cmd.key != "slabs")
+                    throw std::invalid_argument("Usage: INFO [stats|latency|slabs|all]");
+            }
+        } else if (verb == "LATENCY") {
+            cmd.type = CommandType::LATENCY;
+            if (tokens.size() >= 2) {
+                cmd.key = toUpper(tokens[1]);
+                if (cmd.key != "RESET") throw std::invalid_argument("Usage: LATENCY [RESET]");
+            }
+        } else if (verb == "SLOWLOG") {
+            static const char* usage = "Usage: SLOWLOG GET [count] | LEN | RESET";
+            if (tokens.size() < 2) throw std::invalid_argument(usage);
+            cmd.type  = CommandType::SLOWLOG;
+            cmd.key   = toUpper(tokens[1]);
+            cmd.delta = 10;
+            if (cmd.key == "GET" && tokens.size() >= 3) {
+                try {
+                    size_t used = 0;
+                    cmd.delta = std::stoll(tokens[2], &used);
+                    if (used != tokens[2].size()) throw std::invalid_argument("trailing");
+                    if (cmd.delta < 0) throw std::invalid_argument("negative");
+                } catch (const std::exception&) {
+                    throw std::invalid_argument("Invalid SLOWLOG count: " + tokens[2]);
+                }
+            } else if (cmd.key != "GET" && cmd.key != "LEN" && cmd.key != "RESET") {
+                throw std::invalid_argument(usage);
+            }
         } else if (verb == "SAVE") {
             cmd.type = CommandType::SAVE;
         } else if (verb == "EXIT" || verb == "QUIT" || verb == "Q") {
@@ -107,6 +242,19 @@ public:
     }
 
 private:
+    // Positive seconds for EX options.
+    static long long parseTtl(const std::string& tok) {
+        try {
+            size_t used = 0;
+            long long ttl = std::stoll(tok, &used);
+            if (used != tok.size()) throw std::invalid_argument("trailing");
+            if (ttl <= 0) throw std::invalid_argument("TTL must be positive");
+            return ttl;
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Invalid TTL value: " + tok);
+        }
+    }
+
     // Split on whitespace
     std::vector<std::string> tokenise(const std::string& s) const {
         std::vector<std::string> tokens;
@@ -120,4 +268,9 @@ private:
         std::transform(s.begin(), s.end(), s.begin(), ::toupper);
         return s;
     }
+
+    std::string toLower(std::string s) const {
+        std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+        return s;
+    }
 };
@@ -0,0 +1,279 @@
+#pragma once
+#include "command_parser.h"
+#include "slowlog.h"
+#include "store.h"
+
+#include <cctype>
+#include <exception>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * CommandExecutor — runs one command line against a KVStore and encodes the
+ * reply for a wire transport (Unix socket, shared-memory ring).
+ *
+ * Requests are inline command lines, exactly as typed into the REPL, and go
+ * through the same CommandParser → KVStore path. Replies use RESP2 framing so
+ * clients can find reply boundaries without knowing the command:
+ *
+ *   +OK\r\n                 status
+ *   -ERR message\r\n        error
+ *   :42\r\n                 integer
+ *   $5\r\nhello\r\n         bulk string   ($-1\r\n = nil)
+ *   *2\r\n$1\r\na\r\n...    array of bulk strings
+ *
+ * Thread safety: execute() is safe to call from many threads at once; all
+ * shared state lives in the KVStore and the (lock-free) SlowLog.
+ */
+class CommandExecutor {
+public:
+    // `slowlog` may be null (SLOWLOG commands then reply with an error).
+    CommandExecutor(KVStore& store, std::string snapshot_file, SlowLog* slowlog = nullptr)
+        : store_(store), snapshot_file_(std::move(snapshot_file)), slowlog_(slowlog) {}
+
+    // Executes one request line and returns the encoded reply.
+    // Sets `close` when the client asked to end the session (EXIT / QUIT).
+    std::string execute(const std::string& line, bool& close) const {
+        close = false;
+        Command cmd;
+        try {
+            cmd = parser_.parse(line);
+        } catch (const std::exception& ex) {
+            return error(ex.what());
+        }
+        if (!slowlog_) return dispatch(cmd, close);
+
+        KVStore::takeLockContended();
+        const uint64_t start = CycleClock::now();
+        std::string reply = dispatch(cmd, close);
+        const uint64_t end = CycleClock::now();
+        if (end > start && slowlog_->slow(end - start)) logSlow(*slowlog_, cmd, end - start);
+        return reply;
+    }
+
+    // Slow-path only: called once a command is known to be over threshold.
+    static void logSlow(SlowLog& log, const Command& cmd, uint64_t ticks) {
+        std::string name = cmd.raw.substr(0, cmd.raw.find_first_of(" \t"));
+        name.erase(0, name.find_first_not_of(" \t"));
+        for (auto& c : name) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+        const std::string& key = cmd.key.empty() && !cmd.args.empty() ? cmd.args[0] : cmd.key;
+        uint64_t value_bytes = cmd.value.size();
+        if (cmd.type == CommandType::MSET)
+            for (size_t i = 1; i < cmd.args.size(); i += 2) value_bytes += cmd.args[i].size();
+        log.record(name, key, value_bytes, ticks, KVStore::takeLockContended());
+    }
+
+private:
+    std::string dispatch(const Command& cmd, bool& close) const {
+        switch (cmd.type) {
+            case CommandType::SET: {
+                SetResult r = store_.set(cmd.key, cmd.value, setOptionsOf(cmd));
+                if (cmd.get_old) return r.old_value ? bulk(*r.old_value) : nil();
+                return r.applied ? status("OK") : nil();
+            }
+            case CommandType::GET: {
+                auto val = store_.get(cmd.key);
+                return val ? bulk(*val) : nil();
+            }
+            case CommandType::GETS: {
+                auto val = store_.gets(cmd.key);
+                if (!val) return nil();
+                return "*2\r\n" + bulk(val->value)
+                     + integer(static_cast<long long>(val->version));
+            }
+            case CommandType::CAS:
+                switch (store_.cas(cmd.key, cmd.value, cmd.version, cmd.ttl)) {
+                    case LRUCache::CasResult::STORED: return status("STORED");
+                    case LRUCache::CasResult::EXISTS: return status("EXISTS");
+                    default:                          return status("NOT_FOUND");
+                }
+            case CommandType::DEL:
+                return integer(store_.del(cmd.key) ? 1 : 0);
+            case CommandType::MGET: {
+                auto vals = store_.mget(cmd.args);
+                std::string out = "*" + std::to_string(vals.size()) + "\r\n";
+                for (auto& v : vals) out += v ? bulk(*v) : nil();
+                return out;
+            }
+            case CommandType::MSET:
+                store_.mset(pairsOf(cmd.args));
+                return status("OK");
+            case CommandType::MDEL:
+                return integer(static_cast<long long>(store_.mdel(cmd.args)));
+            case CommandType::UNLINK:
+                return integer(static_cast<long long>(store_.unlink(cmd.args)));
+            case CommandType::INCR:
+                try {
+                    return integer(store_.incrBy(cmd.key, cmd.delta));
+                } catch (const std::exception& ex) {
+                    return error(ex.what());
+                }
+            case CommandType::TTL:
+                return integer(store_.ttl(cmd.key));
+            case CommandType::KEYS: {
+                auto ks = store_.keys();
+                std::string out = "*" + std::to_string(ks.size()) + "\r\n";
+                for (auto& k : ks) out += bulk(k);
+                return out;
+            }
+            case CommandType::FLUSH:
+                store_.flush(cmd.key == "ASYNC");
+                return status("OK");
+            case CommandType::STATS:
+                return bulk(formatStats(store_.stats()));
+            case CommandType::INFO: {
+                std::string out;
+                if (cmd.key.empty() || cmd.key == "stats")
+                    out += "# Stats\r\n" + formatStats(store_.stats());
+                if (cmd.key.empty() || cmd.key == "latency")
+                    out += "# Latency\r\n" + formatLatency(store_);
+                if (cmd.key.empty() || cmd.key == "slabs")
+                    out += "# Slabs\r\n" + formatSlabs(store_.stats().slabs);
+                return bulk(out);
+            }
+            case CommandType::LATENCY:
+                if (cmd.key == "RESET") {
+                    store_.resetLatency();
+                    return status("OK");
+                }
+                return bulk(formatLatency(store_));
+            case CommandType::SLOWLOG: {
+                if (!slowlog_) return error("slow log is disabled");
+                if (cmd.key == "RESET") {
+                    slowlog_->reset();
+                    return status("OK");
+                }
+                if (cmd.key == "LEN")
+                    return integer(static_cast<long long>(slowlog_->length()));
+                // *N of [id, unix time, µs, command, key, value bytes, contended]
+                auto entries = slowlog_->get(static_cast<size_t>(cmd.delta));
+                std::string out = "*" + std::to_string(entries.size()) + "\r\n";
+                for (auto& e : entries)
+                    out += "*7\r\n" + integer(static_cast<long long>(e.id))
+                         + integer(e.timestamp_us / 1000000)
+                         + integer(static_cast<long long>(e.duration_us))
+                         + bulk(e.command) + bulk(e.key)
+                         + integer(static_cast<long long>(e.value_bytes))
+                         + integer(e.contended ? 1 : 0);
+                return out;
+            }
+            case CommandType::SAVE:
+                try {
+                    store_.save(snapshot_file_);
+                    return status("OK");
+                } catch (const std::exception& ex) {
+                    return error(ex.what());
+                }
+            case CommandType::EXIT:
+                close = true;
+                return status("OK");
+            default:
+                return error("unknown command '" + cmd.raw + "'");
+        }
+    }
+
+public:
+    // ── RESP2 encoders ───────────────────────────────────────────────────────
+
+    static std::string status(const std::string& s) { return "+" + s + "\r\n"; }
+    static std::string error(const std::string& s)  { return "-ERR " + s + "\r\n"; }
+    static std::string integer(long long v)        { return ":" + std::to_string(v) + "\r\n"; }
+    static std::string nil()                        { return "$-1\r\n"; }
+    static std::string bulk(const std::string& s) {
+        return "$" + std::to_string(s.size()) + "\r\n" + s + "\r\n";
+    }
+
+    // SET flags parsed by CommandParser → KVStore options.
+    static SetOptions setOptionsOf(const Command& cmd) {
+        SetOptions opts;
+        opts.ttl_seconds = cmd.ttl;
+        opts.return_old  = cmd.get_old;
+        opts.keep_ttl    = cmd.keep_ttl;
+        if (cmd.nx)      opts.condition = SetOptions::Condition::IF_ABSENT;
+        else if (cmd.xx) opts.condition = SetOptions::Condition::IF_PRESENT;
+        return opts;
+    }
+
+    // MSET argument list k1 v1 k2 v2 ... → pairs.
+    static std::vector<std::pair<std::string, std::string>>
+    pairsOf(const std::vector<std::string>& args) {
+        std::vector<std::pair<std::string, std::string>> pairs;
+        pairs.reserve(args.size() / 2);
+        for (size_t i = 0; i + 1 < args.size(); i += 2)
+            pairs.emplace_back(args[i], args[i + 1]);
+        return pairs;
+    }
+
+    // One INFO-style line per command that has been called since the last
+    // reset, e.g. "latency_get:calls=12,mean=410,p50=380,...,max=9100" (ns).
+    static std::string formatLatency(const KVStore& store) {
+        std::ostringstream os;
+        for (int c = 0; c < LatencyTracker::COUNT; ++c) {
+            auto cmd = static_cast<LatencyTracker::Command>(c);
+            LatencyHistogram h = store.latency(cmd);
+            if (h.count() == 0) continue;
+            os << "latency_" << LatencyTracker::name(cmd) << ":calls=" << h.count()
+               << ",mean=" << static_cast<uint64_t>(h.mean())
+               << ",p50="   << h.percentile(0.50)  << ",p90="   << h.percentile(0.90)
+               << ",p99="   << h.percentile(0.99)  << ",p99.9=" << h.percentile(0.999)
+               << ",max="   << h.max() << "\r\n";
+        }
+        return os.str();
+    }
+
+private:
+    // INFO-style "field:value" lines.
+    static std::string formatStats(const Stats& s) {
+        std::ostringstream os;
+        os << "keys:"        << s.current_keys << "\r\n"
+           << "capacity:"    << s.capacity     << "\r\n"
+           << "hits:"        << s.hits         << "\r\n"
+           << "misses:"      << s.misses       << "\r\n"
+           << "sets:"        << s.sets         << "\r\n"
+           << "dels:"        << s.dels         << "\r\n"
+           << "evictions:"   << s.evictions    << "\r\n"
+           << "expirations:" << s.expirations  << "\r\n"
+           << "used_memory:" << s.used_memory  << "\r\n"
+           << "maxmemory:"   << s.max_memory   << "\r\n"
+           << "eviction_policy:" << s.eviction_policy << "\r\n"
+           << "maxmemory_policy:" << s.maxmemory_policy << "\r\n";
+        size_t reserved = 0, used = 0;
+        for (auto& c : s.slabs) { reserved += c.reserved; used += c.in_use * c.size; }
+        os << "slab_reserved:" << reserved << "\r\n"
+           << "slab_used:"     << used     << "\r\n"
+           << std::fixed << std::setprecision(2)
+           << "slab_fragmentation_ratio:" << s.slab_fragmentation << "\r\n"
+           << "defrag_cycles:"            << s.defrag_cycles      << "\r\n"
+           << "defrag_moved:"             << s.defrag_moved       << "\r\n"
+           << "defrag_released_bytes:"    << s.defrag_released    << "\r\n"
+           << "defrag_last_ratio_before:" << s.defrag_before      << "\r\n"
+           << "defrag_last_ratio_after:"  << s.defrag_after       << "\r\n";
+        for (auto& [name, l] : s.locks)
+            os << "lock_" << name << ":acquisitions=" << l.acquisitions
+               << ",contended=" << l.contended << ",wait_ns=" << l.wait_ns
+               << ",max_hold_ns=" << l.max_hold_ns << "\r\n";
+        return os.str();
+    }
+
+    // One line per slab class, e.g.
+    // "slab_160:reserved=65536,in_use=380,free=29,utilization=92.8" (percent).
+    static std::string formatSlabs(const std::vector<SlabClassStats>& slabs) {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(1);
+        for (auto& c : slabs)
+            os << "slab_" << c.size << ":reserved=" << c.reserved << ",in_use=" << c.in_use
+               << ",free=" << c.free << ",utilization="
+               << 100.0 * static_cast<double>(c.in_use * c.size) / static_cast<double>(c.reserved)
+               << "\r\n";
+        return os.str();
+    }
+
+    KVStore&      store_;
+    std::string   snapshot_file_;
+    SlowLog*      slowlog_;
+    CommandParser parser_;
+};
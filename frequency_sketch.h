@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * FrequencySketch — 4-bit count-min sketch with periodic aging (TinyLFU)
+ *
+ * Estimates how often a key hash has been seen recently, in [0, 15]. The
+ * table is one 64-bit word per slot (sized to the next power of two of the
+ * expected key count), and each word packs sixteen 4-bit counters. A hash
+ * picks one group of four counters inside each of four words (one per
+ * hash function). increment() bumps the four counters, saturating at 15,
+ * and frequency() returns their minimum.
+ *
+ * Aging: after 10 × capacity increments every counter is halved. Keys that
+ * were popular yesterday fade, and the sample stays a sliding window of
+ * recent history. Halving is a shift-and-mask over the table.
+ *
+ * Not synchronised; the owner serialises access.
+ */
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t capacity = 16) { resize(capacity); }
+
+    // Grows the table for `capacity` expected keys. Counts are discarded
+    // (as on any resize); shrinking is ignored.
+    void ensureCapacity(size_t capacity) {
+        if (capacity > capacity_) resize(capacity);
+    }
+
+    void increment(uint64_t hash) {
+        const int start = static_cast<int>((spread(hash) & 3) << 2);
+        bool added = false;
+        for (int i = 0; i < 4; ++i) {
+            uint64_t& word  = table_[indexOf(hash, i)];
+            const int shift = (start + i) << 2;
+            if (((word >> shift) & 0xF) != 0xF) {
+                word += uint64_t(1) << shift;
+                added = true;
+            }
+        }
+        if (added && ++additions_ >= sample_size_) age();
+    }
+
+    int frequency(uint64_t hash) const {
+        const int start = static_cast<int>((spread(hash) & 3) << 2);
+        int freq = 0xF;
+        for (int i = 0; i < 4; ++i) {
+            const int shift = (start + i) << 2;
+            freq = std::min(freq, static_cast<int>((table_[indexOf(hash, i)] >> shift) & 0xF));
+        }
+        return freq;
+    }
+
+    size_t bytes() const { return table_.size() * sizeof(uint64_t); }
+
+private:
+    void resize(size_t capacity) {
+        size_t slots = 16;
+        while (slots < capacity) slots <<= 1;
+        capacity_    = std::max<size_t>(capacity, 16);
+        sample_size_ = 10 * capacity_;
+        additions_   = 0;
+        mask_        = slots - 1;
+        table_.assign(slots, 0);
+    }
+
+    // Halve every counter: drop each nibble's low bit and shift it down.
+    void age() {
+        for (auto& word : table_) word = (word >> 1) & 0x7777777777777777ull;
+        additions_ /= 2;
+    }
+
+    static uint64_t spread(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t indexOf(uint64_t hash, int i) const {
+        static constexpr uint64_t SEEDS[4] = {0xC3A5C85C97CB3127ull, 0xB492B66FBE98F273ull,
+                                              0x9AE16A3B2F90404Full, 0xCBF29CE484222325ull};
+        uint64_t h = (hash + SEEDS[i]) * SEEDS[i];
+        h += h >> 32;
+        return static_cast<size_t>(h) & mask_;
+    }
+
+    std::vector<uint64_t> table_;
+    size_t                mask_        = 0;
+    size_t                capacity_    = 0;
+    size_t                sample_size_ = 0;
+    size_t                additions_   = 0;
+};
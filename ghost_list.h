@@ -0,0 +1,68 @@
+#pragma once
+#include "memory_usage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+/**
+ * GhostList — recency-ordered set of recently evicted keys, by hash only
+ *
+ * ARC's B1 / B2 lists remember what was evicted, not the data: a later miss
+ * on a remembered key tells the policy it evicted from the wrong side.
+ * Keys are stored as their 64-bit hash (no string, no value), so a ghost
+ * costs two small nodes. A hash collision can only make one miss look like
+ * a ghost hit, which nudges the adaptation slightly.
+ *
+ * Not synchronised; the owner serialises access.
+ */
+class GhostList {
+public:
+    bool contains(uint64_t hash) const { return index_.count(hash) > 0; }
+
+    // Adds at the MRU end (moves it there if already present).
+    void push(uint64_t hash) {
+        erase(hash);
+        order_.push_front(hash);
+        index_[hash] = order_.begin();
+    }
+
+    bool erase(uint64_t hash) {
+        auto it = index_.find(hash);
+        if (it == index_.end()) return false;
+        order_.erase(it->second);
+        index_.erase(it);
+        return true;
+    }
+
+    void popOldest() {
+        if (order_.empty()) return;
+        index_.erase(order_.back());
+        order_.pop_back();
+    }
+
+    size_t size()  const { return index_.size(); }
+    bool   empty() const { return index_.empty(); }
+
+    void clear() {
+        order_.clear();
+        index_.clear();
+    }
+
+    void swap(GhostList& other) {
+        order_.swap(other.order_);
+        index_.swap(other.index_);
+    }
+
+    // Estimated heap bytes (see MemoryUsage).
+    size_t bytes() const {
+        static constexpr size_t NODE = MemoryUsage::chunk(2 * sizeof(void*) + sizeof(uint64_t));
+        static constexpr size_t SLOT = MemoryUsage::hashNode<uint64_t, std::list<uint64_t>::iterator>();
+        return size() * (NODE + SLOT) + MemoryUsage::buckets(index_.bucket_count());
+    }
+
+private:
+    std::list<uint64_t>                                        order_; // front = MRU
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> index_;
+};
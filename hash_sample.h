@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+/**
+ * sampleEntry — a pseudo-random element of an unordered container
+ *
+ * Picks a bucket from `r`, walks forward to the first non-empty bucket and
+ * returns one of its elements. Elements in sparse runs of buckets are picked
+ * a little more often, which is fine for eviction sampling (Redis makes the
+ * same trade). Expected O(1) at the containers' load factor of at most one;
+ * a map that has shrunk far below its bucket count probes longer.
+ *
+ * Returns nullptr for an empty container.
+ */
+template <typename Map>
+const typename Map::value_type* sampleEntry(const Map& m, uint64_t r) {
+    if (m.empty()) return nullptr;
+    const size_t n = m.bucket_count();
+    size_t b = static_cast<size_t>(r % n);
+    for (size_t i = 0; i < n; ++i, b = (b + 1 == n ? 0 : b + 1)) {
+        const size_t len = m.bucket_size(b);
+        if (len == 0) continue;
+        auto it = m.begin(b);
+        std::advance(it, static_cast<size_t>((r >> 32) % len));
+        return &*it;
+    }
+    return nullptr;
+}
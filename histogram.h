@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/**
+ * LatencyHistogram — fixed-size log-linear histogram of nanosecond samples
+ *
+ * Bucketing (HdrHistogram-style, 5 sub-bucket bits):
+ *   - values 0..31 get one exact bucket each
+ *   - above that, every power-of-two range [2^e, 2^(e+1)) is split into
+ *     32 equal sub-buckets, so any recorded value is within ~3% of its
+ *     bucket's representative value
+ *
+ * 1,920 buckets cover the full uint64 range in 15 KB with no allocation,
+ * so record() is a clz, a shift and an increment. Histograms are not
+ * synchronised: each thread records into its own and they are merge()d.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int      SUB_BITS = 5;
+    static constexpr uint64_t SUB      = uint64_t(1) << SUB_BITS;   // 32
+    static constexpr size_t   BUCKETS  = (64 - SUB_BITS + 1) * SUB; // 1920
+
+    void record(uint64_t ns) {
+        ++counts_[indexOf(ns)];
+        ++count_;
+        sum_ += ns;
+        if (ns > max_) max_ = ns;
+    }
+
+    // Adds `n` samples of value `ns` (rebuilding from another histogram's buckets).
+    void record(uint64_t ns, uint64_t n) {
+        if (n == 0) return;
+        counts_[indexOf(ns)] += n;
+        count_ += n;
+        sum_   += ns * n;
+        if (ns > max_) max_ = ns;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKETS; ++i) counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        sum_   += other.sum_;
+        max_    = std::max(max_, other.max_);
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    // Value at quantile q in [0, 1] (e.g. 0.999 for p99.9); 0 if empty.
+    uint64_t percentile(double q) const {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count_));
+        if (rank >= count_) rank = count_ - 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts_[i];
+            if (seen > rank) return std::min(valueOf(i), max_);
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max()   const { return max_; }
+    double   mean()  const {
+        return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0;
+    }
+
+    // Raw bucket access for exporters.
+    uint64_t bucketCount(size_t i) const { return counts_[i]; }
+
+    static size_t indexOf(uint64_t v) {
+        if (v < SUB) return static_cast<size_t>(v);
+        int e     = 63 - __builtin_clzll(v);               // v in [2^e, 2^(e+1))
+        int shift = e - SUB_BITS;                          // keep top SUB_BITS+1 bits
+        size_t group = static_cast<size_t>(shift + 1);
+        size_t sub   = static_cast<size_t>((v >> shift) - SUB);
+        return group * SUB + sub;
+    }
+
+    // Midpoint of bucket i.
+    static uint64_t valueOf(size_t i) {
+        size_t group = i / SUB;
+        uint64_t sub = i % SUB;
+        if (group == 0) return sub;
+        int shift = static_cast<int>(group) - 1;
+        uint64_t lo    = (SUB + sub) << shift;
+        uint64_t width = uint64_t(1) << shift;
+        return lo + width / 2;
+    }
+
+private:
+    std::array<uint64_t, BUCKETS> counts_{};
+    uint64_t                      count_ = 0;
+    uint64_t                      sum_   = 0;
+    uint64_t                      max_   = 0;
+};
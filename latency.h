@@ -0,0 +1,143 @@
+#pragma once
+#include "histogram.h"
+#include "thread_stripes.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * CycleClock — cheapest available monotonic tick source
+ *
+ * On x86 this is the TSC (rdtsc, a few ns, no syscall/vDSO); elsewhere
+ * steady_clock nanoseconds. nsPerTick() calibrates ticks against
+ * steady_clock over the whole process lifetime, so it gets more precise
+ * the longer the process runs. It is only called on the read path.
+ */
+struct CycleClock {
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    static double nsPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+        using SC = std::chrono::steady_clock;
+        // Guarantee a usable baseline if called right after startup.
+        while (SC::now() - origin_.second < std::chrono::milliseconds(10)) {}
+        uint64_t ticks = now() - origin_.first;
+        double   ns    = std::chrono::duration<double, std::nano>(SC::now() - origin_.second).count();
+        return ticks ? ns / static_cast<double>(ticks) : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+
+private:
+    // Captured during static initialisation, i.e. at process start.
+    static inline const std::pair<uint64_t, std::chrono::steady_clock::time_point> origin_{
+        now(), std::chrono::steady_clock::now()};
+};
+
+/**
+ * LatencyTracker — per-command latency histograms with ~zero hot-path cost
+ *
+ * record() costs two tick reads (LatencyScope), a thread_local lookup and a
+ * relaxed load + store into the calling thread's own bucket array. It takes
+ * no lock and uses no atomic read-modify-write, and it never touches a
+ * cache line another thread writes. Buckets are the
+ * LatencyHistogram log-linear layout in raw ticks; histogram() sums every
+ * thread's stripe and converts to nanoseconds on read.
+ *
+ * reset() doesn't zero live stripes (their owners may be writing). It
+ * records the current totals as a baseline that histogram() subtracts. The
+ * max is therefore the top bucket's representative value, within ~3%.
+ */
+class LatencyTracker {
+public:
+    enum Command { GET, GETS, SET, CAS, INCR, DEL, MGET, MSET, MDEL, UNLINK, TTL, KEYS,
+                   FLUSH, SAVE, LOAD, COUNT };
+
+    static const char* name(Command c) {
+        static const char* names[COUNT] = {"get", "gets", "set", "cas", "incr", "del",
+                                           "mget", "mset", "mdel", "unlink", "ttl", "keys",
+                                           "flush", "save", "load"};
+        return names[c];
+    }
+
+    void record(Command c, uint64_t ticks) {
+        auto& bucket = stripes_.local().counts[c][LatencyHistogram::indexOf(ticks)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Latencies of `c` since the last reset(), in nanoseconds.
+    LatencyHistogram histogram(Command c) const {
+        std::lock_guard<std::mutex> lock(baseline_mutex_); // totals must not predate the baseline
+        std::vector<uint64_t> totals = sum(c);
+        const double scale = CycleClock::nsPerTick();
+        LatencyHistogram h;
+        for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            uint64_t n = totals[i] - (baseline_.empty() ? 0 : baseline_[c][i]);
+            if (n) h.record(static_cast<uint64_t>(
+                                static_cast<double>(LatencyHistogram::valueOf(i)) * scale), n);
+        }
+        return h;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(baseline_mutex_);
+        std::vector<std::vector<uint64_t>> now;
+        for (int c = 0; c < COUNT; ++c) now.push_back(sum(static_cast<Command>(c)));
+        baseline_ = std::move(now);
+    }
+
+private:
+    struct Stripe {
+        std::atomic<uint64_t> counts[COUNT][LatencyHistogram::BUCKETS];
+    };
+
+    std::vector<uint64_t> sum(Command c) const {
+        std::vector<uint64_t> totals(LatencyHistogram::BUCKETS, 0);
+        stripes_.forEach([&](const Stripe& s) {
+            for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i)
+                totals[i] += s.counts[c][i].load(std::memory_order_relaxed);
+        });
+        return totals;
+    }
+
+    ThreadStripes<Stripe>              stripes_;
+    mutable std::mutex                 baseline_mutex_;
+    std::vector<std::vector<uint64_t>> baseline_; // [command][bucket], empty = never reset
+};
+
+/**
+ * LatencyScope — times the enclosing block into a LatencyTracker.
+ */
+class LatencyScope {
+public:
+    LatencyScope(LatencyTracker& tracker, LatencyTracker::Command cmd)
+        : tracker_(tracker), cmd_(cmd), start_(CycleClock::now()) {}
+    ~LatencyScope() {
+        uint64_t end = CycleClock::now(); // a migration across unsynced TSCs can go backwards
+        tracker_.record(cmd_, end > start_ ? end - start_ : 0);
+    }
+
+    LatencyScope(const LatencyScope&)            = delete;
+    LatencyScope& operator=(const LatencyScope&) = delete;
+
+private:
+    LatencyTracker&         tracker_;
+    LatencyTracker::Command cmd_;
+    uint64_t                start_;
+};
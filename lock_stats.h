@@ -0,0 +1,181 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef CHRONO_LOCK_STATS
+#include "latency.h"
+
+#include <atomic>
+#endif
+
+/**
+ * LockStats — contention counters for one lock, as reported by STATS.
+ */
+struct LockStats {
+    uint64_t acquisitions = 0; // exclusive + shared
+    uint64_t contended    = 0; // acquisitions that had to wait
+    uint64_t wait_ns      = 0; // total time spent waiting
+    uint64_t max_hold_ns  = 0; // longest single hold, exclusive or shared
+};
+
+using NamedLockStats = std::vector<std::pair<std::string, LockStats>>;
+
+/**
+ * ProfiledMutex<M> — a mutex that can report LockStats
+ *
+ * Built with -DCHRONO_LOCK_STATS (make LOCK_STATS=1), ProfiledMutex<M> is
+ * InstrumentedMutex<M> and ProfiledCondVar is condition_variable_any.
+ * Otherwise both are plain aliases for M and std::condition_variable,
+ * so an ordinary build has no instrumentation code at all, and
+ * lockStatsOf() returns nothing.
+ *
+ * Counting cost when enabled: each acquisition does a try_lock and two
+ * tick reads (start and end of the hold). A waiter also does a fetch_add
+ * for its wait time. The counters sit on the mutex's own cache line,
+ * which every acquirer already writes.
+ */
+#ifdef CHRONO_LOCK_STATS
+
+constexpr bool kLockStatsEnabled = true;
+
+template <typename M>
+class InstrumentedMutex {
+public:
+    InstrumentedMutex() = default;
+    InstrumentedMutex(const InstrumentedMutex&)            = delete;
+    InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+    // ── Lockable ─────────────────────────────────────────────────────────────
+
+    void lock() {
+        if (!mutex_.try_lock()) {
+            uint64_t t0 = CycleClock::now();
+            mutex_.lock();
+            waited(t0);
+        }
+        acquired();
+        hold_start_ = CycleClock::now(); // sole holder: a plain write is enough
+    }
+
+    bool try_lock() {
+        if (!mutex_.try_lock()) return false;
+        acquired();
+        hold_start_ = CycleClock::now();
+        return true;
+    }
+
+    void unlock() {
+        uint64_t start = hold_start_;
+        mutex_.unlock();
+        released(start);
+    }
+
+    // ── SharedLockable (only instantiated for shared mutexes) ───────────────
+
+    void lock_shared() {
+        if (!mutex_.try_lock_shared()) {
+            uint64_t t0 = CycleClock::now();
+            mutex_.lock_shared();
+            waited(t0);
+        }
+        acquired();
+        pushShared();
+    }
+
+    bool try_lock_shared() {
+        if (!mutex_.try_lock_shared()) return false;
+        acquired();
+        pushShared();
+        return true;
+    }
+
+    void unlock_shared() {
+        uint64_t start = popShared();
+        mutex_.unlock_shared();
+        released(start);
+    }
+
+    LockStats stats() const {
+        const double scale = CycleClock::nsPerTick();
+        LockStats s;
+        s.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+        s.contended    = contended_.load(std::memory_order_relaxed);
+        s.wait_ns      = static_cast<uint64_t>(
+            static_cast<double>(wait_ticks_.load(std::memory_order_relaxed)) * scale);
+        s.max_hold_ns  = static_cast<uint64_t>(
+            static_cast<double>(max_hold_ticks_.load(std::memory_order_relaxed)) * scale);
+        return s;
+    }
+
+private:
+    void acquired() { acquisitions_.fetch_add(1, std::memory_order_relaxed); }
+
+    void waited(uint64_t t0) {
+        uint64_t t1 = CycleClock::now();
+        contended_.fetch_add(1, std::memory_order_relaxed);
+        wait_ticks_.fetch_add(t1 > t0 ? t1 - t0 : 0, std::memory_order_relaxed);
+    }
+
+    // Runs after the unlock, so the bookkeeping isn't counted as hold time.
+    void released(uint64_t start) {
+        uint64_t end  = CycleClock::now();
+        uint64_t held = end > start ? end - start : 0;
+        uint64_t seen = max_hold_ticks_.load(std::memory_order_relaxed);
+        while (held > seen &&
+               !max_hold_ticks_.compare_exchange_weak(seen, held, std::memory_order_relaxed)) {}
+    }
+
+    // Shared holds overlap, so each holder keeps its own start tick. A thread
+    // holds few locks at once; a small LIFO stack keyed by mutex is enough.
+    struct HeldShared { const void* mutex; uint64_t start; };
+    static constexpr int MAX_SHARED_HELD = 8;
+    struct SharedStack { HeldShared held[MAX_SHARED_HELD]; int depth = 0; };
+    static SharedStack& sharedStack() { thread_local SharedStack s; return s; }
+
+    void pushShared() {
+        SharedStack& s = sharedStack();
+        if (s.depth < MAX_SHARED_HELD) s.held[s.depth] = {this, CycleClock::now()};
+        ++s.depth; // beyond the stack, holds still count but aren't timed
+    }
+
+    uint64_t popShared() {
+        SharedStack& s = sharedStack();
+        int top = --s.depth;
+        if (top >= MAX_SHARED_HELD) return CycleClock::now();
+        for (int i = top; i >= 0; --i) {
+            if (s.held[i].mutex != this) continue;
+            uint64_t start = s.held[i].start;
+            s.held[i] = s.held[top]; // out-of-order unlock: keep the stack dense
+            return start;
+        }
+        return CycleClock::now();
+    }
+
+    M                     mutex_;
+    uint64_t              hold_start_ = 0;
+    std::atomic<uint64_t> acquisitions_{0};
+    std::atomic<uint64_t> contended_{0};
+    std::atomic<uint64_t> wait_ticks_{0};
+    std::atomic<uint64_t> max_hold_ticks_{0};
+};
+
+template <typename M> using ProfiledMutex = InstrumentedMutex<M>;
+using ProfiledCondVar = std::condition_variable_any;
+
+template <typename M>
+LockStats lockStatsOf(const InstrumentedMutex<M>& m) { return m.stats(); }
+
+#else
+
+constexpr bool kLockStatsEnabled = false;
+
+template <typename M> using ProfiledMutex = M;
+using ProfiledCondVar = std::condition_variable;
+
+template <typename M>
+LockStats lockStatsOf(const M&) { return {}; }
+
+#endif
@@ -1,75 +1,416 @@
 #pragma once
+#include "frequency_sketch.h"
+#include "ghost_list.h"
+#include "hash_sample.h"
+#include "memory_usage.h"
+#include "slab_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <list>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <optional>
 #include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * EvictionPolicy — how LRUCache picks victims (--eviction-policy).
+ *
+ *   LRU      evict the least recently used key
+ *   TINYLFU  W-TinyLFU: a 1% LRU admission window in front of a segmented
+ *            LRU main space (20% probation, 80% protected). A key leaving the
+ *            window only displaces the main space's victim if a
+ *            FrequencySketch says it is accessed more often, so one-hit
+ *            scans can't flush the hot set.
+ *   ARC      Adaptive Replacement Cache: a recency list (T1, seen once) and a
+ *            frequency list (T2, seen again), plus ghost lists of the keys
+ *            each recently evicted. A miss that hits a ghost shifts the T1/T2
+ *            split towards the side that would have kept it.
+ *   SIEVE    one FIFO queue; a hit only sets the entry's visited bit, and a
+ *            hand sweeping from the tail evicts the first unvisited entry,
+ *            clearing bits as it passes. Hits never touch the list, so GET
+ *            needs no lock beyond the owner's shared one.
+ */
+enum class EvictionPolicy { LRU, TINYLFU, ARC, SIEVE };
+
+inline constexpr EvictionPolicy ALL_EVICTION_POLICIES[] = {
+    EvictionPolicy::LRU, EvictionPolicy::TINYLFU, EvictionPolicy::ARC, EvictionPolicy::SIEVE};
+
+inline const char* evictionPolicyName(EvictionPolicy p) {
+    switch (p) {
+        case EvictionPolicy::LRU:     return "lru";
+        case EvictionPolicy::TINYLFU: return "tinylfu";
+        case EvictionPolicy::ARC:     return "arc";
+        case EvictionPolicy::SIEVE:   return "sieve";
+    }
+    return "?";
+}
+
+// @throws std::invalid_argument for an unknown name.
+inline EvictionPolicy parseEvictionPolicy(const std::string& name) {
+    if (name == "lru")                            return EvictionPolicy::LRU;
+    if (name == "tinylfu" || name == "w-tinylfu") return EvictionPolicy::TINYLFU;
+    if (name == "arc")                            return EvictionPolicy::ARC;
+    if (name == "sieve")                          return EvictionPolicy::SIEVE;
+    throw std::invalid_argument("unknown eviction policy: " + name
+                                + " (lru | tinylfu | arc | sieve)");
+}
 
 /**
  * LRUCache — O(1) Least Recently Used Cache
  *
  * Data Structures:
- *   - std::list<pair<key,value>>  → doubly-linked list (cache ordering)
- *   - std::unordered_map<key, list::iterator> → O(1) lookup
+ *   - std::list<Entry>  → doubly-linked lists (cache ordering); LRU uses one,
+ *     TINYLFU one per segment (window / probation / protected), ARC two
+ *     (T1 on RECENT, T2 on PROTECTED), SIEVE one FIFO
+ *   - std::unordered_map<key, list::iterator> → O(1) lookup. Moving a node
+ *     between lists is a splice, so iterators stay valid. The index keys
+ *     are views of the entries' own keys, so each key is stored once.
  *
- * Policy:
+ * Policy (LRU):
  *   - GET  : move accessed node to front (most recently used)
  *   - SET  : insert at front; if over capacity, evict from back
  *   - DEL  : erase from both structures in O(1)
+ *
+ * Policy (TINYLFU):
+ *   - GET / SET / miss : count the key in the frequency sketch
+ *   - hit  : window and protected move to their front; probation is promoted
+ *            to protected, demoting protected's LRU back to probation
+ *   - SET  : insert at the window front; the window's LRU, once it overflows,
+ *            moves to probation as the admission candidate
+ *   - evict: the candidate competes with probation's LRU (the victim); the
+ *            less frequent of the two goes, the candidate on a tie
+ *
+ * Policy (ARC):
+ *   - SET  : a new key goes to the T1 front, or to T2 if a ghost list
+ *            remembers it; a B1 ghost grows T1's target size p, a B2 ghost
+ *            shrinks it
+ *   - hit  : move to the T2 front
+ *   - evict: T1's LRU while T1 is above p, else T2's LRU; the victim's hash
+ *            joins B1 or B2. Ghosts are trimmed so |T1| + |B1| <= c and the
+ *            whole directory stays within 2c. DEL leaves no ghost.
+ *
+ * Policy (SIEVE):
+ *   - hit  : set the visited bit (relaxed atomic store), nothing else
+ *   - SET  : insert at the queue head, unvisited
+ *   - evict: the hand walks from its last position towards the head
+ *            (wrapping to the tail), clearing visited bits, and evicts the
+ *            first unvisited entry; the hand stays where it stopped
+ *
+ * Concurrency:
+ *   - Not internally synchronised for writers; the owner serialises SET/DEL.
+ *   - GET may run concurrently under the owner's shared lock: lookups are
+ *     read-only and the recency splice (and sketch update) is serialised on
+ *     order_mutex_. SIEVE hits only store a visited bit and skip the mutex.
+ *   - So under the shared lock, list nodes move at any time. Anything that
+ *     walks a whole list (forEach: KEYS, SAVE) must hold order_mutex_ or
+ *     the owner's exclusive lock; index lookups and sample() need neither.
+ *   - Counter increments on existing counter entries are also shared-lock
+ *     safe: the value is a std::atomic<int64_t> updated with a CAS loop.
+ *
+ * Memory:
+ *   - memoryUsage() is a running byte count of every entry (list node,
+ *     index node, key, value buffer) plus the index's bucket
+ *     array, the sketch and the ghost lists, kept exact on each write. The
+ *     owner enforces maxmemory with evictBytes(); the key-count capacity
+ *     still applies on its own.
+ *   - List nodes, index nodes and buckets, and value buffers come from the
+ *     SlabPool's size classes (SlabAllocator), and are counted at class
+ *     size. Keys stay plain std::string, as the API hands them out.
+ *     defrag() moves an entry's slab objects out of slabs being drained.
+ *   - With setLazyFree(true), evicted nodes are unlinked into a graveyard
+ *     instead of destroyed, as are unlink()ed ones; the owner hands
+ *     takeGraveyard() to another thread to free. detach() does the same for
+ *     the whole cache in O(1). Entries leave the byte count when unlinked.
+ *
+ * Versions:
+ *   - Every write stamps the entry with a fresh, store-wide unique version
+ *     (CAS token). Tokens never repeat, so a DEL + re-SET cannot resurrect
+ *     a token a client is still holding.
  */
 class LRUCache {
 public:
     using Key   = std::string;
     using Value = std::string;
-    using Node  = std::pair<Key, Value>;
+    using Buffer = std::basic_string<char, std::char_traits<char>, SlabAllocator<char>>;
+    using Expiry = std::chrono::steady_clock::time_point; // {} = no TTL
+
+    /**
+     * Entry — one cached key.
+     *
+     * Counter entries (INCR / DECR) keep a native int64 in `counter` and leave
+     * `value` empty, so increments never format or reallocate a string.
+     * `is_counter` only changes under the owner's exclusive lock.
+     *
+     * `expires` is the key's TTL deadline ({} = none), which the owner's
+     * TTLManager keeps under the owner's exclusive lock; its deadline index
+     * points at `key`, so a key never changes while the entry is indexed.
+     */
+    struct Entry {
+        Key                   key;
+        Buffer                value;
+        std::atomic<int64_t>  counter{0};
+        std::atomic<uint64_t> version{0};
+        bool                  is_counter = false;
+        uint8_t               segment    = 0; // list the node is on (Segment)
+        std::atomic<bool>     visited{false}; // SIEVE: hit since the hand last passed
+        std::atomic<uint32_t> accessed{0};    // write clock at the last read or write
+        Expiry                expires{};
+
+        Entry(const Key& k, const Value& v) : key(k), value(v.data(), v.size()) {}
+        Entry(const Key& k, int64_t n) : key(k), counter(n), is_counter(true) {}
+
+        // Takes over `o`'s value buffer (defrag() moving a node). The key is
+        // copied: the TTL index may read `o.key` until on_move has run.
+        Entry(Entry&& o)
+            : key(o.key), value(std::move(o.value)),
+              counter(o.counter.load(std::memory_order_relaxed)),
+              version(o.version.load(std::memory_order_relaxed)),
+              is_counter(o.is_counter), segment(o.segment),
+              visited(o.visited.load(std::memory_order_relaxed)),
+              accessed(o.accessed.load(std::memory_order_relaxed)), expires(o.expires) {}
+
+        // String form of the value, whatever the representation.
+        Value str() const {
+            return is_counter ? std::to_string(counter.load(std::memory_order_relaxed))
+                              : Value(value.data(), value.size());
+        }
+    };
+    using Node = Entry;
+
+    // Value plus the CAS token it was read at (GETS).
+    struct Versioned {
+        Value    value;
+        uint64_t version = 0;
+    };
 
-    explicit LRUCache(size_t capacity) : capacity_(capacity) {
+    enum class CasResult { STORED, EXISTS, NOT_FOUND };
+
+    static constexpr size_t UNLIMITED = SIZE_MAX; // no key-count limit (maxmemory only)
+
+    // Overrides the policy's choice of victim (the owner's volatile-* and
+    // *-random maxmemory policies). Called with exclusive access and the
+    // key that must survive (the last one written, or nullptr); returns
+    // false to leave the choice to the policy. A returned key that is
+    // present and not `keep` is evicted.
+    using VictimPicker = std::function<bool(const Key* keep, Key& victim)>;
+
+    // Keep the owner's deadline index, which points at entries' keys, in
+    // step. Called with exclusive access for entries with a deadline:
+    // DropHook just before one leaves the cache, MoveHook after defrag()
+    // copies one to a new node (`from` is still intact). clear() and
+    // detach() skip them; the owner empties its index first.
+    using DropHook = std::function<void(Entry& e)>;
+    using MoveHook = std::function<void(const Entry& from, Entry& to)>;
+
+    // Evicted entries awaiting deallocation (lazy free).
+    using Graveyard = std::list<Entry, SlabAllocator<Entry>>;
+
+    // Key → list node, keyed by a view of the entry's own key. Its nodes and
+    // bucket array are slab-allocated too.
+    using KeyRef = std::string_view;
+    using Index  = std::unordered_map<KeyRef, Graveyard::iterator, std::hash<KeyRef>,
+                                      std::equal_to<KeyRef>,
+                                      SlabAllocator<std::pair<const KeyRef, Graveyard::iterator>>>;
+
+    // The whole cache as detach() hands it over.
+    struct Detached {
+        Graveyard entries;
+        Index     index;
+        GhostList ghosts[2];
+    };
+
+    explicit LRUCache(size_t capacity, EvictionPolicy policy = EvictionPolicy::LRU)
+        : capacity_(capacity), policy_(policy) {
         if (capacity_ == 0) throw std::invalid_argument("LRU capacity must be > 0");
-        map_.reserve(capacity_);
+        if (capacity_ != UNLIMITED) {
+            map_.reserve(capacity_);
+            if (policy_ == EvictionPolicy::TINYLFU) sketch_.ensureCapacity(capacity_);
+        }
     }
 
     // Returns the value for key, or nullopt if not found.
     // Moves the accessed node to front (marks as recently used).
     std::optional<Value> get(const Key& key) {
         auto it = map_.find(key);
-        if (it == map_.end()) return std::nullopt;
-        // Splice to front — O(1)
-        list_.splice(list_.begin(), list_, it->second);
-        return it->second->second;
+        if (it == map_.end()) {
+            recordMiss(key);
+            return std::nullopt;
+        }
+        hit(it->second);
+        return it->second->str();
+    }
+
+    // Like get(), but also returns the entry's current version.
+    // The version is read before the value, so a racing counter increment can
+    // only make the pair look older — a later CAS then fails safely.
+    std::optional<Versioned> getVersioned(const Key& key) {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            recordMiss(key);
+            return std::nullopt;
+        }
+        hit(it->second);
+        Versioned v;
+        v.version = it->second->version.load(std::memory_order_acquire);
+        v.value   = it->second->str();
+        return v;
+    }
+
+    // Batched GET: one pass resolves every key and prefetches its list node,
+    // a second prefetches the value buffers, and only then are values copied,
+    // so the per-key cache misses overlap instead of serialising.
+    // Same concurrency contract as get().
+    std::vector<std::optional<Value>> getMany(const std::vector<Key>& keys) {
+        std::vector<Index::iterator> found(keys.size(), map_.end());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto it = map_.find(keys[i]);
+            if (it == map_.end()) continue;
+            found[i] = it;
+            __builtin_prefetch(&*it->second);
+        }
+        for (auto& it : found)
+            if (it != map_.end()) __builtin_prefetch(it->second->value.data());
+
+        std::vector<std::optional<Value>> out(keys.size());
+        std::unique_lock<std::mutex> lock(order_mutex_, std::defer_lock);
+        if (policy_ != EvictionPolicy::SIEVE) lock.lock();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (found[i] == map_.end()) {
+                if (policy_ == EvictionPolicy::TINYLFU) sketch_.increment(hashOf(keys[i]));
+                continue;
+            }
+            touch(found[i]->second);
+            out[i] = found[i]->second->str();
+        }
+        return out;
     }
 
     // Inserts or updates the key.
     // If key exists, update value and move to front.
-    // If capacity exceeded after insert, evict LRU (back of list).
-    // Returns the evicted key if one occurred, otherwise "".
-    Key set(const Key& key, const Value& value) {
-        Key evicted;
+    // If capacity exceeded after insert, evict per the policy.
+    // Returns the evicted key if one occurred, otherwise "". `written`, if
+    // given, receives the entry now holding the key.
+    Key set(const Key& key, const Value& value, Entry** written = nullptr) {
         auto it = map_.find(key);
         if (it != map_.end()) {
+            if (written) *written = &*it->second;
             // Update in place and move to front
-            it->second->second = value;
-            list_.splice(list_.begin(), list_, it->second);
+            used_bytes_ -= valueBytes(it->second->value);
+            it->second->value.assign(value.data(), value.size());
+            it->second->is_counter = false;
+            used_bytes_ += valueBytes(it->second->value);
+            stamp(*it->second);
+            touch(it->second);
+            return Key();
+        }
+        List::iterator node = insert(key, value);
+        if (written) *written = &*node;
+        return evictIfFull(); // never the newest entry
+    }
+
+    // Stores `value` only if the entry's version still equals `version`.
+    // Requires exclusive access.
+    CasResult compareAndSet(const Key& key, const Value& value, uint64_t version) {
+        auto it = map_.find(key);
+        if (it == map_.end()) return CasResult::NOT_FOUND;
+        Entry& e = *it->second;
+        if (e.version.load(std::memory_order_relaxed) != version) return CasResult::EXISTS;
+        used_bytes_ -= valueBytes(e.value);
+        e.value.assign(value.data(), value.size());
+        e.is_counter = false;
+        used_bytes_ += valueBytes(e.value);
+        stamp(e);
+        touch(it->second);
+        return CasResult::STORED;
+    }
+
+    // ── Counters ─────────────────────────────────────────────────────────────
+
+    enum class IncrResult { DONE, MISSING, NOT_COUNTER };
+
+    // Fast path, safe under the owner's shared lock: adds `delta` in place to
+    // an existing counter entry. Returns MISSING / NOT_COUNTER when the caller
+    // must fall back to increment() under its exclusive lock.
+    // @throws std::overflow_error if the result would not fit in int64.
+    IncrResult incrementExisting(const Key& key, int64_t delta, int64_t& result) {
+        auto it = map_.find(key);
+        if (it == map_.end())        return IncrResult::MISSING;
+        Entry& e = *it->second;
+        if (!e.is_counter)           return IncrResult::NOT_COUNTER;
+
+        int64_t cur = e.counter.load(std::memory_order_relaxed);
+        do {
+            if (__builtin_add_overflow(cur, delta, &result))
+                throw std::overflow_error("increment or decrement would overflow");
+        } while (!e.counter.compare_exchange_weak(cur, result, std::memory_order_relaxed));
+        stampConcurrent(e);
+        hit(it->second);
+        return IncrResult::DONE;
+    }
+
+    // Slow path, requires exclusive access: creates a counter (starting at 0)
+    // or converts a string entry that holds a decimal integer, then adds.
+    // Returns the evicted key if the insert overflowed capacity, otherwise "".
+    // @throws std::invalid_argument if the existing value is not an integer.
+    // @throws std::overflow_error if the result would not fit in int64.
+    Key increment(const Key& key, int64_t delta, int64_t& result) {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            insert(key, delta);
+            result = delta;
+            return evictIfFull();
+        }
+
+        Entry& e = *it->second;
+        int64_t cur = 0;
+        if (e.is_counter) {
+            cur = e.counter.load(std::memory_order_relaxed);
         } else {
-            // Insert at front
-            list_.emplace_front(key, value);
-            map_[key] = list_.begin();
-            // Evict LRU if over capacity
-            if (map_.size() > capacity_) {
-                evicted = list_.back().first;
-                map_.erase(evicted);
-                list_.pop_back();
-            }
+            const char* first = e.value.data();
+            const char* last  = first + e.value.size();
+            auto [ptr, ec] = std::from_chars(first, last, cur);
+            if (e.value.empty() || ec != std::errc() || ptr != last)
+                throw std::invalid_argument("value is not an integer or out of range");
         }
-        return evicted;
+        if (__builtin_add_overflow(cur, delta, &result))
+            throw std::overflow_error("increment or decrement would overflow");
+
+        if (!e.is_counter) {
+            used_bytes_ -= valueBytes(e.value);
+            Buffer().swap(e.value); // release the string buffer
+            e.is_counter = true;
+        }
+        e.counter.store(result, std::memory_order_relaxed);
+        stamp(e);
+        touch(it->second);
+        return Key();
     }
 
     // Removes a key from cache. Returns true if it existed.
-    bool del(const Key& key) {
+    bool del(const Key& key) { return remove(key, false); }
+
+    // Like del(), but the node goes to the graveyard for the owner to free
+    // elsewhere (UNLINK).
+    bool unlink(const Key& key) { return remove(key, true); }
+
+    // Looks up an entry without updating recency; nullptr if absent.
+    const Entry* peek(const Key& key) const {
         auto it = map_.find(key);
-        if (it == map_.end()) return false;
-        list_.erase(it->second);
-        map_.erase(it);
-        return true;
+        return it == map_.end() ? nullptr : &*it->second;
+    }
+    Entry* peek(const Key& key) {
+        auto it = map_.find(key);
+        return it == map_.end() ? nullptr : &*it->second;
     }
 
     // Checks existence without updating recency.
@@ -77,19 +418,458 @@ public:
         return map_.count(key) > 0;
     }
 
-    // Expose all entries (in MRU→LRU order) for persistence.
-    const std::list<Node>& entries() const { return list_; }
+    // Visits every entry (for persistence / KEYS), segment by segment, each
+    // from MRU to LRU. Holds order_mutex_ for the walk, so concurrent hits
+    // cannot splice nodes out from under it; `f` must not call back in.
+    template <typename F>
+    void forEach(F&& f) const {
+        std::unique_lock<std::mutex> lock(order_mutex_, std::defer_lock);
+        if (policy_ != EvictionPolicy::SIEVE) lock.lock();
+        for (auto& list : lists_)
+            for (auto& e : list) f(static_cast<const Entry&>(e));
+    }
+
+    // A pseudo-random entry (see sampleEntry); nullptr if empty.
+    const Entry* sample(uint64_t r) const {
+        auto* slot = sampleEntry(map_, r);
+        return slot ? &*slot->second : nullptr;
+    }
+
+    // Writes since the entry was last read or written: a logical idle time
+    // for sampled LRU. Wraps after 2^32 writes, like Redis's LRU clock.
+    uint32_t idle(const Entry& e) const {
+        return static_cast<uint32_t>(next_version_.load(std::memory_order_relaxed))
+             - e.accessed.load(std::memory_order_relaxed);
+    }
+
+    void setVictimPicker(VictimPicker picker) { picker_ = std::move(picker); }
+
+    void setDeadlineHooks(DropHook on_drop, MoveHook on_move) {
+        on_drop_ = std::move(on_drop);
+        on_move_ = std::move(on_move);
+    }
+
+    void setLazyFree(bool on) { lazy_free_ = on; }
+    bool hasGraveyard() const   { return !graveyard_.empty(); }
+
+    // Hands over the entries evicted or unlinked since the last call, O(1).
+    Graveyard takeGraveyard() {
+        Graveyard dead;
+        dead.swap(graveyard_);
+        return dead;
+    }
 
     size_t size()     const { return map_.size(); }
     size_t capacity() const { return capacity_; }
+    EvictionPolicy policy() const { return policy_; }
+
+    // Bytes a value buffer owns in the SlabPool (0 while inline).
+    static size_t valueBytes(const Buffer& v) {
+        return v.capacity() > MemoryUsage::SSO_CAPACITY ? SlabPool::bytesFor(v.capacity() + 1) : 0;
+    }
+
+    // Estimated heap bytes held by the cache (see MemoryUsage).
+    size_t memoryUsage() const {
+        const size_t buckets = map_.bucket_count();  // one bucket is inline
+        return used_bytes_ + (buckets > 1 ? SlabPool::bytesFor(buckets * sizeof(void*)) : 0)
+             + (policy_ == EvictionPolicy::TINYLFU ? MemoryUsage::chunk(sketch_.bytes()) : 0)
+             + b1_.bytes() + b2_.bytes();
+    }
+
+    // Evicts per the policy, as one batch, until at least `bytes` have been
+    // freed, or `max_keys` are gone. The newest entry is never evicted, so a
+    // just-written key survives even if it alone exceeds the budget. Returns
+    // the evicted keys.
+    std::vector<Key> evictBytes(size_t bytes, size_t max_keys = SIZE_MAX) {
+        std::vector<Key> evicted;
+        size_t freed = 0;
+        while (freed < bytes && evicted.size() < max_keys && map_.size() > 1) {
+            auto victim = chooseVictim();
+            size_t b = entryBytes(*victim);
+            evicted.push_back(evict(victim));
+            freed += b;
+        }
+        return evicted;
+    }
+
+    // Evicts up to `count` entries per the policy, sparing the newest.
+    std::vector<Key> evictKeys(size_t count) {
+        std::vector<Key> evicted;
+        while (evicted.size() < count && map_.size() > 1)
+            evicted.push_back(evict(chooseVictim()));
+        return evicted;
+    }
 
     void clear() {
-        list_.clear();
+        for (auto& list : lists_) list.clear();
+        graveyard_.clear();
         map_.clear();
+        b1_.clear();
+        b2_.clear();
+        resetPolicy();
+    }
+
+    // Active defragmentation: moves each list node, index node and value
+    // buffer that sits in a slab the SlabPool is draining to a fresh
+    // allocation. Scans at most `buckets` index buckets from `cursor` and
+    // returns where to resume, or 0 once the whole index has been scanned;
+    // adds the allocations moved to `moved`. Requires exclusive access. A
+    // cursor is only meaningful while bucketCount() is unchanged.
+    size_t bucketCount() const { return map_.bucket_count(); }
+
+    size_t defrag(size_t cursor, size_t buckets, size_t& moved) {
+        const size_t n = map_.bucket_count();
+        std::vector<List::iterator> nodes; // list / index nodes to move after the scan
+        size_t b = cursor;
+        for (size_t end = std::min(n, cursor + buckets); b < end; ++b) {
+            for (auto it = map_.begin(b); it != map_.end(b); ++it) {
+                Entry& e = *it->second;
+                if (e.value.capacity() > MemoryUsage::SSO_CAPACITY
+                    && SlabPool::draining(e.value.data(), e.value.capacity() + 1)) {
+                    Buffer fresh(e.value);
+                    used_bytes_ -= valueBytes(e.value);
+                    e.value.swap(fresh);
+                    used_bytes_ += valueBytes(e.value);
+                    ++moved;
+                }
+                if (SlabPool::draining(&e, NODE_REQUEST) || SlabPool::draining(&*it, SLOT_REQUEST))
+                    nodes.push_back(it->second);
+            }
+        }
+        // A moved list node carries a new key, so its index node is re-keyed
+        // (or replaced, if draining too). Same bucket, no rehash.
+        for (auto node : nodes) {
+            auto it = map_.find(node->key);
+            const bool slot = SlabPool::draining(&*it, SLOT_REQUEST);
+            auto handle = map_.extract(it);
+            if (SlabPool::draining(&*node, NODE_REQUEST)) {
+                node = relocate(node);
+                ++moved;
+            }
+            if (slot) {
+                map_.emplace(node->key, node);
+                ++moved;
+            } else {
+                handle.key()    = node->key;
+                handle.mapped() = node;
+                map_.insert(std::move(handle));
+            }
+        }
+        return b < n ? b : 0;
+    }
+
+    // Empties the cache in O(1) and returns its contents for the owner to
+    // destroy elsewhere (FLUSH ASYNC). The index keeps no buckets.
+    Detached detach() {
+        Detached d;
+        for (auto& list : lists_) d.entries.splice(d.entries.end(), list);
+        d.entries.splice(d.entries.end(), graveyard_);
+        d.index.swap(map_);
+        d.ghosts[0].swap(b1_);
+        d.ghosts[1].swap(b2_);
+        resetPolicy();
+        return d;
     }
 
 private:
+    using List = Graveyard;
+
+    // RECENT is the LRU list, TINYLFU's admission window, or ARC's T1;
+    // PROTECTED is also ARC's T2.
+    enum Segment : uint8_t { RECENT = 0, PROBATION = 1, PROTECTED = 2, SEGMENTS = 3 };
+
+    bool remove(const Key& key, bool to_graveyard) {
+        auto it = map_.find(key);
+        if (it == map_.end()) return false;
+        List::iterator node = it->second;
+        forget(node);
+        map_.erase(it);
+        if (to_graveyard) graveyard_.splice(graveyard_.end(), lists_[node->segment], node);
+        else              lists_[node->segment].erase(node);
+        return true;
+    }
+
+    // Per-policy state of an empty cache; the lists and index are empty.
+    void resetPolicy() {
+        used_bytes_    = 0;
+        has_candidate_ = false;
+        arc_p_         = 0;
+        from_b2_       = false;
+        has_hand_      = false;
+        newest_        = nullptr;
+    }
+
+    // Assigns a fresh version; caller has exclusive access.
+    void stamp(Entry& e) {
+        uint64_t v = next_version_.fetch_add(1, std::memory_order_relaxed);
+        e.version.store(v, std::memory_order_release);
+        e.accessed.store(static_cast<uint32_t>(v), std::memory_order_relaxed);
+        newest_ = &e;
+    }
+
+    void markAccess(Entry& e) {
+        e.accessed.store(static_cast<uint32_t>(next_version_.load(std::memory_order_relaxed)),
+                         std::memory_order_relaxed);
+    }
+
+    // Assigns a fresh version while other shared-lock writers may race on the
+    // same entry: only ever move the version forward so it stays monotonic.
+    void stampConcurrent(Entry& e) {
+        uint64_t v   = next_version_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t cur = e.version.load(std::memory_order_relaxed);
+        while (cur < v &&
+               !e.version.compare_exchange_weak(cur, v, std::memory_order_release,
+                                                std::memory_order_relaxed)) {}
+    }
+
+    uint64_t hashOf(const Key& key) const { return map_.hash_function()(key); }
+
+    // ── Policy hooks ─────────────────────────────────────────────────────────
+
+    // New key at the front of RECENT (ARC may start it on PROTECTED);
+    // returns its node. Caller has exclusive access.
+    template <typename V>
+    List::iterator insert(const Key& key, V&& v) {
+        List& recent = lists_[RECENT];
+        recent.emplace_front(key, std::forward<V>(v));
+        const List::iterator node = recent.begin();
+        stamp(*node);
+        map_.emplace(node->key, node);
+        used_bytes_ += entryBytes(*node);
+
+        if (policy_ == EvictionPolicy::ARC) {
+            admitGhost(key, node);
+            return node;
+        }
+        if (policy_ != EvictionPolicy::TINYLFU) return node;
+        if (capacity_ == UNLIMITED) sketch_.ensureCapacity(map_.size());
+        sketch_.increment(hashOf(key));
+        if (recent.size() > windowLimit()) {
+            // Window overflow: its LRU becomes the admission candidate.
+            auto cand = std::prev(recent.end());
+            moveTo(cand, PROBATION);
+            candidate_     = cand;
+            has_candidate_ = true;
+        }
+        return node;
+    }
+
+    // ARC: a new key whose hash is still on a ghost list was evicted too
+    // early. Adapt p towards the list that lost it and start it on T2.
+    void admitGhost(const Key& key, List::iterator it) {
+        const uint64_t h = hashOf(key);
+        if (b1_.erase(h)) {
+            size_t delta = std::max<size_t>(1, b2_.size() / (b1_.size() + 1));
+            arc_p_ = std::min(budget(), arc_p_ + delta);
+            moveTo(it, PROTECTED);
+        } else if (b2_.erase(h)) {
+            size_t delta = std::max<size_t>(1, b1_.size() / (b2_.size() + 1));
+            arc_p_   = arc_p_ > delta ? arc_p_ - delta : 0;
+            from_b2_ = true;
+            moveTo(it, PROTECTED);
+        }
+    }
+
+    // A hit under the owner's shared lock.
+    void hit(List::iterator it) {
+        if (policy_ == EvictionPolicy::SIEVE) {
+            it->visited.store(true, std::memory_order_relaxed);
+            markAccess(*it);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(order_mutex_);
+        touch(it);
+    }
+
+    // A hit; caller holds order_mutex_ or exclusive access.
+    void touch(List::iterator it) {
+        markAccess(*it);
+        if (policy_ == EvictionPolicy::SIEVE) {
+            it->visited.store(true, std::memory_order_relaxed);
+            return;
+        }
+        if (policy_ == EvictionPolicy::LRU) {
+            lists_[RECENT].splice(lists_[RECENT].begin(), lists_[RECENT], it);
+            return;
+        }
+        if (policy_ == EvictionPolicy::ARC) {
+            moveTo(it, PROTECTED); // also refreshes an entry already on T2
+            return;
+        }
+        sketch_.increment(hashOf(it->key));
+        if (it->segment != PROBATION) {
+            lists_[it->segment].splice(lists_[it->segment].begin(), lists_[it->segment], it);
+            return;
+        }
+        if (has_candidate_ && candidate_ == it) has_candidate_ = false;
+        moveTo(it, PROTECTED);
+        if (lists_[PROTECTED].size() > protectedLimit())
+            moveTo(std::prev(lists_[PROTECTED].end()), PROBATION);
+    }
+
+    void recordMiss(const Key& key) {
+        if (policy_ != EvictionPolicy::TINYLFU) return;
+        std::lock_guard<std::mutex> lock(order_mutex_);
+        sketch_.increment(hashOf(key));
+    }
+
+    // The picker's victim if it names a valid one, else the policy's. Never
+    // the entry written last: reads since may have aged it to a list's LRU
+    // end (background reclaim), so the next entry along goes instead.
+    List::iterator chooseVictim() {
+        Key key;
+        if (picker_ && picker_(newest_ ? &newest_->key : nullptr, key)) {
+            auto it = map_.find(key);
+            if (it != map_.end() && &*it->second != newest_) return it->second;
+        }
+        auto victim = pickVictim();
+        if (&*victim != newest_) return victim;
+        List& own = lists_[victim->segment];
+        if (std::next(victim) != own.end()) return std::next(victim);
+        if (victim != own.begin())          return std::prev(victim);
+        for (auto& other : lists_) // alone on its list; there are at least two entries
+            if (&other != &own && !other.empty()) return std::prev(other.end());
+        return victim;
+    }
+
+    // Next entry to evict; the cache is non-empty.
+    List::iterator pickVictim() {
+        if (policy_ == EvictionPolicy::LRU) return std::prev(lists_[RECENT].end());
+        if (policy_ == EvictionPolicy::SIEVE) return sweep();
+        if (policy_ == EvictionPolicy::ARC) {
+            const List& t1 = lists_[RECENT];
+            bool from_t1 = !t1.empty() && (t1.size() > arc_p_ || (from_b2_ && t1.size() == arc_p_)
+                                           || lists_[PROTECTED].empty());
+            from_b2_ = false;
+            return std::prev(lists_[from_t1 ? RECENT : PROTECTED].end());
+        }
+
+        List* main = !lists_[PROBATION].empty() ? &lists_[PROBATION]
+                   : !lists_[PROTECTED].empty() ? &lists_[PROTECTED] : nullptr;
+        if (!main) return std::prev(lists_[RECENT].end());
+        auto victim = std::prev(main->end());
+        if (has_candidate_ && candidate_ != victim) {
+            has_candidate_ = false;
+            if (sketch_.frequency(hashOf(candidate_->key)) <= sketch_.frequency(hashOf(victim->key)))
+                return candidate_; // not admitted
+        }
+        return victim;
+    }
+
+    // SIEVE: advance the hand to the first unvisited entry. The entry written
+    // last is skipped, so a full pass always ends on another; there are at
+    // least two.
+    List::iterator sweep() {
+        List& q = lists_[RECENT];
+        auto it = has_hand_ ? hand_ : std::prev(q.end());
+        while (&*it == newest_ || it->visited.load(std::memory_order_relaxed)) {
+            it->visited.store(false, std::memory_order_relaxed);
+            it = it == q.begin() ? std::prev(q.end()) : std::prev(it);
+        }
+        hand_     = it;
+        has_hand_ = true;
+        return it;
+    }
+
+    void moveTo(List::iterator it, Segment to) {
+        lists_[to].splice(lists_[to].begin(), lists_[it->segment], it);
+        it->segment = to;
+    }
+
+    // Segment sizes scale with the key-count capacity, or with the current
+    // key count when only maxmemory bounds the cache.
+    size_t budget() const { return capacity_ != UNLIMITED ? capacity_ : map_.size(); }
+    size_t windowLimit()    const { return std::max<size_t>(1, budget() / 100); }
+    size_t protectedLimit() const { return (budget() - budget() / 100) * 8 / 10; }
+
+    // Bookkeeping for an entry about to be erased.
+    void forget(List::iterator it) {
+        if (it->expires != Expiry{} && on_drop_) on_drop_(*it);
+        if (has_candidate_ && candidate_ == it) has_candidate_ = false;
+        if (newest_ == &*it) newest_ = nullptr;
+        if (has_hand_ && hand_ == it) { // the hand moves on towards the head
+            has_hand_ = it != lists_[it->segment].begin();
+            if (has_hand_) hand_ = std::prev(it);
+        }
+        used_bytes_ -= entryBytes(*it);
+    }
+
+    Key erase(List::iterator it) {
+        forget(it);
+        map_.erase(it->key);
+        Key key = std::move(it->key);
+        if (lazy_free_) graveyard_.splice(graveyard_.end(), lists_[it->segment], it);
+        else            lists_[it->segment].erase(it);
+        return key;
+    }
+
+    // Allocation sizes of a list node and an index node (libstdc++ layout:
+    // two links; next link, pair, cached hash).
+    static constexpr size_t NODE_REQUEST = 2 * sizeof(void*) + sizeof(Node);
+    static constexpr size_t SLOT_REQUEST = sizeof(void*) + sizeof(Index::value_type) + sizeof(size_t);
+
+    // List node + index node (both slab objects) + the key + the value
+    // buffer.
+    static size_t entryBytes(const Entry& e) {
+        static constexpr size_t NODE = SlabPool::bytesFor(NODE_REQUEST);
+        static constexpr size_t SLOT = SlabPool::bytesFor(SLOT_REQUEST);
+        return NODE + SLOT + MemoryUsage::heap(e.key) + valueBytes(e.value);
+    }
+
+    // Moves an entry to a new list node in the same position (defrag()).
+    List::iterator relocate(List::iterator old) {
+        List& list = lists_[old->segment];
+        auto fresh = list.emplace(old, std::move(*old));
+        if (newest_ == &*old)          newest_ = &*fresh;
+        if (has_hand_ && hand_ == old) hand_   = fresh;
+        if (has_candidate_ && candidate_ == old) candidate_ = fresh;
+        if (fresh->expires != Expiry{} && on_move_) on_move_(*old, *fresh);
+        list.erase(old);
+        return fresh;
+    }
+
+    // Erases a policy victim; ARC remembers its hash on a ghost list.
+    Key evict(List::iterator it) {
+        if (policy_ != EvictionPolicy::ARC) return erase(it);
+        (it->segment == RECENT ? b1_ : b2_).push(hashOf(it->key));
+        Key key = erase(it);
+        const size_t c = budget();
+        while (!b1_.empty() && lists_[RECENT].size() + b1_.size() > c) b1_.popOldest();
+        while (!b2_.empty() && map_.size() + b1_.size() + b2_.size() > 2 * c) b2_.popOldest();
+        return key;
+    }
+
+    // Evicts one entry if the last insert pushed us over capacity.
+    Key evictIfFull() {
+        if (map_.size() <= capacity_) return Key();
+        return evict(chooseVictim());
+    }
+
     size_t                                        capacity_;
-    std::list<Node>                               list_; // front = MRU, back = LRU
-    std::unordered_map<Key, std::list<Node>::iterator> map_;
+    EvictionPolicy                                policy_;
+    List                                          lists_[SEGMENTS]; // front = MRU, back = LRU
+    Index                                         map_;
+    mutable std::mutex                            order_mutex_; // read-path splices and list walks
+    size_t                                        used_bytes_ = 0; // entries only; owner-serialised
+    std::atomic<uint64_t>                         next_version_{1};
+    const Entry*                                  newest_ = nullptr; // last written, never evicted
+    VictimPicker                                  picker_;
+    DropHook                                      on_drop_;
+    MoveHook                                      on_move_;
+    bool                                          lazy_free_ = false;
+    List                                          graveyard_; // evicted, not yet freed
+
+    // TINYLFU only
+    FrequencySketch                               sketch_;
+    List::iterator                                candidate_;           // window evictee awaiting admission
+    bool                                          has_candidate_ = false;
+
+    // ARC only
+    GhostList                                     b1_, b2_;  // hashes evicted from T1 / T2
+    size_t                                        arc_p_   = 0; // target size of T1
+    bool                                          from_b2_ = false; // last insert was a B2 ghost hit
+
+    // SIEVE only
+    List::iterator                                hand_;             // next entry the sweep examines
+    bool                                          has_hand_ = false; // false: start at the tail
 };
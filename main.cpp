@@ -1,10 +1,36 @@
 /**
  * main.cpp -- ChronoStore Interactive REPL
  *
- * Usage:  chronostore.exe [--capacity N] [--snapshot FILE] [--no-load]
+ * Usage:  chronostore.exe [--capacity N] [--maxmemory BYTES] [--eviction-policy P]
+ *                         [--maxmemory-policy P] [--evict-headroom PCT]
+ *                         [--active-defrag PCT]
+ *                         [--snapshot FILE] [--no-load]
+ *                         [--unix-socket PATH] [--shm NAME]... [--no-repl]
+ *                         [--slowlog-threshold-us N] [--slowlog-max-len N]
+ *
+ * --maxmemory takes a byte count with an optional kb / mb / gb suffix. Given
+ * without --capacity, it is the only limit (no key-count cap).
+ * --eviction-policy picks victims for either limit: lru (default) | tinylfu | arc | sieve.
+ * --maxmemory-policy narrows which keys may go: allkeys-lru (default, the
+ * --eviction-policy order) | allkeys-random | volatile-lru | volatile-random
+ * | volatile-ttl.
+ * --evict-headroom PCT evicts in the background to stay PCT percent under
+ * each limit and frees evicted values on that thread (lazy free).
+ * --active-defrag PCT moves entries out of sparse slabs in the background
+ * once the slabs reserve PCT percent more memory than the entries use.
  *
  * On startup : Loads snapshot if it exists.
  * On EXIT    : Auto-saves snapshot to disk.
+ *
+ * Co-located clients (POSIX only):
+ *   --unix-socket PATH  serve inline commands / RESP replies on an AF_UNIX socket
+ *   --shm NAME          serve one client over a shared-memory SPSC ring pair
+ *                       (repeatable, one segment per client)
+ *   --no-repl           run headless until SIGINT / SIGTERM
+ *
+ * Slow log (all transports):
+ *   --slowlog-threshold-us N  log commands taking >= N µs (default 10000, <0 = off)
+ *   --slowlog-max-len N       entries retained (default 128)
  */
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -13,12 +39,24 @@
 
 #include "store.h"
 #include "command_parser.h"
+#include "executor.h"
+#ifndef _WIN32
+#include "shm_ring.h"
+#include "unix_server.h"
+
+#include <csignal>
+#include <memory>
+#include <pthread.h>
+#endif
 
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 
 // ---- ANSI colour helpers (Windows 10+ supports VT sequences) ----------------
 namespace col {
@@ -62,38 +100,152 @@ static void printHelp() {
     std::cout << col::bold << "\n  Commands:\n" << col::reset;
     std::cout << "  +-----------------------------------------------+\n";
     std::cout << "  |  " << col::green << "SET" << col::reset   << "   <key> <value> [EX <seconds>]      |\n";
+    std::cout << "  |        [NX|XX] [GET] [KEEPTTL]                |\n";
+    std::cout << "  |  " << col::green << "GETSET" << col::reset << " <key> <value>  (swap, return old) |\n";
     std::cout << "  |  " << col::green << "GET" << col::reset   << "   <key>                             |\n";
+    std::cout << "  |  " << col::green << "GETS" << col::reset  << "  <key>   (value + CAS version)     |\n";
+    std::cout << "  |  " << col::green << "CAS" << col::reset   << "   <key> <value> <version> [EX <s>]  |\n";
     std::cout << "  |  " << col::green << "DEL" << col::reset   << "   <key>                             |\n";
+    std::cout << "  |  " << col::green << "MGET" << col::reset  << "  <key> [key ...]                   |\n";
+    std::cout << "  |  " << col::green << "MSET" << col::reset  << "  <key> <value> [key value ...]     |\n";
+    std::cout << "  |  " << col::green << "MDEL" << col::reset  << "  <key> [key ...]                   |\n";
+    std::cout << "  |  " << col::green << "UNLINK" << col::reset << " <key> [key ...] (free in bg)     |\n";
+    std::cout << "  |  " << col::green << "INCR" << col::reset  << "  <key>   / DECR <key>              |\n";
+    std::cout << "  |  " << col::green << "INCRBY" << col::reset << " <key> <increment>               |\n";
     std::cout << "  |  " << col::green << "TTL" << col::reset   << "   <key>   (seconds remaining)       |\n";
     std::cout << "  |  " << col::green << "KEYS" << col::reset  << "  (list all live keys)               |\n";
-    std::cout << "  |  " << col::green << "FLUSH" << col::reset << " (delete all keys)                   |\n";
+    std::cout << "  |  " << col::green << "FLUSH" << col::reset << " [ASYNC] (delete all keys)           |\n";
     std::cout << "  |  " << col::green << "STATS" << col::reset << " (engine counters)                   |\n";
+    std::cout << "  |  " << col::green << "LATENCY" << col::reset << " [RESET] (per-command latency)   |\n";
+    std::cout << "  |  " << col::green << "INFO" << col::reset  << "  [stats|latency|slabs]             |\n";
+    std::cout << "  |  " << col::green << "SLOWLOG" << col::reset << " GET [n] | LEN | RESET          |\n";
     std::cout << "  |  " << col::green << "SAVE" << col::reset  << "  (write snapshot to disk)           |\n";
     std::cout << "  |  " << col::green << "EXIT" << col::reset  << "  (save & quit)                      |\n";
     std::cout << "  +-----------------------------------------------+\n\n";
 }
 
+static std::string humanBytes(size_t bytes) {
+    static const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+    double v = static_cast<double>(bytes);
+    int    u = 0;
+    while (v >= 1024.0 && u < 4) { v /= 1024.0; ++u; }
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(u ? 2 : 0) << v << units[u];
+    return os.str();
+}
+
 static void printStats(const Stats& s) {
     std::cout << "\n";
     std::cout << col::bold << "  +---- ChronoStore Stats ----------------------+\n" << col::reset;
-    std::cout << "  |  Keys      : " << std::setw(10) << s.current_keys
-              << " / " << s.capacity << "\n";
+    std::cout << "  |  Keys      : " << std::setw(10) << s.current_keys;
+    if (s.capacity != LRUCache::UNLIMITED) std::cout << " / " << s.capacity;
+    std::cout << "\n";
     std::cout << "  |  Hits      : " << col::green << std::setw(10) << s.hits   << col::reset << "\n";
     std::cout << "  |  Misses    : " << col::red   << std::setw(10) << s.misses << col::reset << "\n";
     std::cout << "  |  SETs      : " << std::setw(10) << s.sets        << "\n";
     std::cout << "  |  DELs      : " << std::setw(10) << s.dels        << "\n";
-    std::cout << "  |  Evictions : " << std::setw(10) << s.evictions   << "\n";
+    std::cout << "  |  Evictions : " << std::setw(10) << s.evictions
+              << "  (" << s.eviction_policy << ", " << s.maxmemory_policy << ")\n";
     std::cout << "  |  Expirations: " << std::setw(9) << s.expirations << "\n";
+    std::cout << "  |  Memory    : " << std::setw(10) << humanBytes(s.used_memory);
+    if (s.max_memory) std::cout << " / " << humanBytes(s.max_memory);
+    std::cout << "\n";
+    size_t reserved = 0, used = 0;
+    for (auto& c : s.slabs) { reserved += c.reserved; used += c.in_use * c.size; }
+    if (reserved)
+        std::cout << "  |  Slabs     : " << std::setw(10) << humanBytes(used) << " / "
+                  << humanBytes(reserved) << " reserved (x" << std::fixed
+                  << std::setprecision(2) << s.slab_fragmentation << ")\n";
+    if (s.defrag_cycles)
+        std::cout << "  |  Defrag    : " << std::setw(10) << s.defrag_cycles << " cycles, "
+                  << s.defrag_moved << " moved, " << humanBytes(s.defrag_released)
+                  << " released\n"
+                  << "  |              last x" << s.defrag_before << " -> x"
+                  << s.defrag_after << "\n";
     if (s.hits + s.misses > 0) {
         double ratio = 100.0 * static_cast<double>(s.hits)
                              / static_cast<double>(s.hits + s.misses);
         std::cout << "  |  Hit Ratio : " << std::setw(9) << std::fixed
                   << std::setprecision(1) << ratio << "%\n";
     }
+    for (auto& [name, l] : s.locks) {
+        std::cout << "  |  Lock " << std::left << std::setw(6) << name << std::right
+                  << ": " << l.acquisitions << " acq, " << l.contended << " contended\n"
+                  << "  |               wait " << l.wait_ns / 1000 << " us total, max hold "
+                  << l.max_hold_ns / 1000 << " us\n";
+    }
     std::cout << col::bold << "  +--------------------------------------------+\n" << col::reset;
     std::cout << "\n";
 }
 
+// Per-command percentiles since the last LATENCY RESET, in microseconds.
+static void printLatency(const KVStore& store) {
+    std::cout << "\n";
+    std::cout << col::bold << "  +---- Command Latency (us) -------------------------------------+\n"
+              << col::reset;
+    std::cout << "  |  " << std::left << std::setw(7) << "cmd" << std::right
+              << std::setw(10) << "calls" << std::setw(9) << "p50" << std::setw(9) << "p90"
+              << std::setw(9) << "p99" << std::setw(9) << "p99.9" << std::setw(9) << "max" << "\n";
+    bool any = false;
+    for (int c = 0; c < LatencyTracker::COUNT; ++c) {
+        auto cmd = static_cast<LatencyTracker::Command>(c);
+        LatencyHistogram h = store.latency(cmd);
+        if (h.count() == 0) continue;
+        any = true;
+        auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+        std::cout << "  |  " << col::green << std::left << std::setw(7)
+                  << LatencyTracker::name(cmd) << col::reset << std::right
+                  << std::setw(10) << h.count() << std::fixed << std::setprecision(2)
+                  << std::setw(9) << us(h.percentile(0.50)) << std::setw(9) << us(h.percentile(0.90))
+                  << std::setw(9) << us(h.percentile(0.99)) << std::setw(9) << us(h.percentile(0.999))
+                  << std::setw(9) << us(h.max()) << "\n";
+    }
+    if (!any) std::cout << "  |  " << col::grey << "(no commands recorded)" << col::reset << "\n";
+    std::cout << col::bold << "  +---------------------------------------------------------------+\n"
+              << col::reset << "\n";
+}
+
+// Per size class of the process-wide SlabPool.
+static void printSlabs(const std::vector<SlabClassStats>& slabs) {
+    std::cout << "\n";
+    std::cout << col::bold << "  +---- Slab Classes -----------------------------------+\n"
+              << col::reset;
+    std::cout << "  |  " << std::setw(7) << "size" << std::setw(11) << "reserved"
+              << std::setw(10) << "in use" << std::setw(10) << "free" << std::setw(8) << "util" << "\n";
+    for (auto& c : slabs) {
+        double util = 100.0 * static_cast<double>(c.in_use * c.size)
+                            / static_cast<double>(c.reserved);
+        std::cout << "  |  " << col::green << std::setw(7) << c.size << col::reset
+                  << std::setw(11) << humanBytes(c.reserved) << std::setw(10) << c.in_use
+                  << std::setw(10) << c.free << std::setw(7) << std::fixed
+                  << std::setprecision(1) << util << "%\n";
+    }
+    if (slabs.empty()) std::cout << "  |  " << col::grey << "(no slabs allocated)" << col::reset << "\n";
+    std::cout << col::bold << "  +-----------------------------------------------------+\n"
+              << col::reset << "\n";
+}
+
+// Newest first: id, age, duration, command, key, value size, lock wait.
+static void printSlowLog(const SlowLog& log, size_t count) {
+    auto entries = log.get(count);
+    if (entries.empty()) {
+        std::cout << col::grey << "  (empty slow log)" << col::reset << "\n";
+        return;
+    }
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (auto& e : entries) {
+        std::cout << "  " << col::cyan << std::setw(4) << e.id << ")" << col::reset
+                  << col::grey << std::setw(6) << (now - e.timestamp_us) / 1000000 << "s ago  "
+                  << col::reset << col::yellow << std::setw(9) << e.duration_us << " us  "
+                  << col::reset << e.command;
+        if (!e.key.empty()) std::cout << " " << e.key;
+        if (e.value_bytes)  std::cout << col::grey << "  (" << e.value_bytes << " value bytes)" << col::reset;
+        if (e.contended)    std::cout << col::red << "  [lock wait]" << col::reset;
+        std::cout << "\n";
+    }
+}
+
 // ---- Portable file-exists (no <filesystem>) ---------------------------------
 static bool fileExists(const std::string& path) {
     std::ifstream f(path);
@@ -103,21 +255,68 @@ static bool fileExists(const std::string& path) {
 // ---- Argument parsing -------------------------------------------------------
 struct Config {
     size_t      capacity      = KVStore::DEFAULT_CAPACITY;
+    bool        capacity_set  = false;
+    size_t      max_memory    = 0;        // bytes; 0 = no limit
+    EvictionPolicy policy     = EvictionPolicy::LRU;
+    MaxmemoryPolicy mm_policy = MaxmemoryPolicy::ALLKEYS_LRU;
+    double      evict_headroom_pct = 0;   // > 0 = async eviction + lazy free
+    double      active_defrag_pct  = 0;   // > 0 = background slab defragmentation
     std::string snapshot_file = KVStore::SNAPSHOT_FILE;
     bool        no_load       = false;
+    std::string unix_socket;              // "" = no socket listener
+    std::vector<std::string> shm_names;   // one SPSC segment per entry
+    bool        no_repl       = false;
+    long long   slowlog_threshold_us = 10000; // < 0 disables the slow log
+    size_t      slowlog_max_len      = 128;
 };
 
+// "4096", "512kb", "64mb", "2gb" (case-insensitive, binary multiples).
+static size_t parseBytes(const std::string& text) {
+    size_t used = 0;
+    unsigned long long n = std::stoull(text, &used);
+    std::string unit = text.substr(used);
+    std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
+    if (unit.empty() || unit == "b") return static_cast<size_t>(n);
+    if (unit == "kb" || unit == "k") return static_cast<size_t>(n) << 10;
+    if (unit == "mb" || unit == "m") return static_cast<size_t>(n) << 20;
+    if (unit == "gb" || unit == "g") return static_cast<size_t>(n) << 30;
+    throw std::invalid_argument("bad size: " + text);
+}
+
 static Config parseArgs(int argc, char* argv[]) {
     Config cfg;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
-        if ((arg == "--capacity" || arg == "-c") && i + 1 < argc)
-            cfg.capacity = static_cast<size_t>(std::stoul(argv[++i]));
+        if ((arg == "--capacity" || arg == "-c") && i + 1 < argc) {
+            cfg.capacity     = static_cast<size_t>(std::stoul(argv[++i]));
+            cfg.capacity_set = true;
+        }
+        else if (arg == "--maxmemory" && i + 1 < argc)
+            cfg.max_memory = parseBytes(argv[++i]);
+        else if (arg == "--eviction-policy" && i + 1 < argc)
+            cfg.policy = parseEvictionPolicy(argv[++i]);
+        else if (arg == "--maxmemory-policy" && i + 1 < argc)
+            cfg.mm_policy = parseMaxmemoryPolicy(argv[++i]);
+        else if (arg == "--evict-headroom" && i + 1 < argc)
+            cfg.evict_headroom_pct = std::stod(argv[++i]);
+        else if (arg == "--active-defrag" && i + 1 < argc)
+            cfg.active_defrag_pct = std::stod(argv[++i]);
         else if ((arg == "--snapshot" || arg == "-s") && i + 1 < argc)
             cfg.snapshot_file = argv[++i];
         else if (arg == "--no-load")
             cfg.no_load = true;
+        else if (arg == "--unix-socket" && i + 1 < argc)
+            cfg.unix_socket = argv[++i];
+        else if (arg == "--shm" && i + 1 < argc)
+            cfg.shm_names.push_back(argv[++i]);
+        else if (arg == "--no-repl")
+            cfg.no_repl = true;
+        else if (arg == "--slowlog-threshold-us" && i + 1 < argc)
+            cfg.slowlog_threshold_us = std::stoll(argv[++i]);
+        else if (arg == "--slowlog-max-len" && i + 1 < argc)
+            cfg.slowlog_max_len = static_cast<size_t>(std::stoul(argv[++i]));
     }
+    if (cfg.max_memory && !cfg.capacity_set) cfg.capacity = LRUCache::UNLIMITED;
     return cfg;
 }
 
@@ -126,9 +325,20 @@ int main(int argc, char* argv[]) {
     enableAnsi();
 
     Config cfg = parseArgs(argc, argv);
+#ifndef _WIN32
+    // Headless mode waits for these in sigwait(); block them before any
+    // listener thread starts so every thread inherits the mask.
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    if (cfg.no_repl) pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+#endif
     printBanner();
 
-    KVStore store(cfg.capacity);
+    KVStore store(cfg.capacity, cfg.max_memory, cfg.policy, cfg.mm_policy);
+    if (cfg.evict_headroom_pct > 0) store.enableAsyncEviction(cfg.evict_headroom_pct / 100.0);
+    if (cfg.active_defrag_pct > 0)  store.enableActiveDefrag(cfg.active_defrag_pct / 100.0);
 
     // Auto-load snapshot on start
     if (!cfg.no_load && fileExists(cfg.snapshot_file)) {
@@ -143,11 +353,64 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    std::cout << col::grey
-              << "  Capacity: " << cfg.capacity
-              << " keys  |  Snapshot: " << cfg.snapshot_file
+    std::cout << col::grey << "  Capacity: "
+              << (cfg.capacity == LRUCache::UNLIMITED ? std::string("unlimited")
+                                                      : std::to_string(cfg.capacity))
+              << " keys  |  ";
+    if (cfg.max_memory) std::cout << "Maxmemory: " << humanBytes(cfg.max_memory) << "  |  ";
+    std::cout << "Eviction: " << evictionPolicyName(cfg.policy);
+    if (cfg.mm_policy != MaxmemoryPolicy::ALLKEYS_LRU)
+        std::cout << " (" << maxmemoryPolicyName(cfg.mm_policy) << ")";
+    if (cfg.evict_headroom_pct > 0)
+        std::cout << ", async " << cfg.evict_headroom_pct << "% headroom";
+    if (cfg.active_defrag_pct > 0)
+        std::cout << "  |  Defrag: > " << cfg.active_defrag_pct << "%";
+    std::cout << "  |  ";
+    std::cout << "Snapshot: " << cfg.snapshot_file
               << col::reset << "\n\n";
 
+    // ---- Co-located client listeners ---------------------------------------
+    const int64_t slow_ticks = cfg.slowlog_threshold_us < 0 ? -1
+        : static_cast<int64_t>(static_cast<double>(cfg.slowlog_threshold_us) * 1000.0
+                               / CycleClock::nsPerTick());
+    SlowLog         slowlog(cfg.slowlog_max_len, slow_ticks, CycleClock::nsPerTick());
+    CommandExecutor executor(store, cfg.snapshot_file, &slowlog);
+#ifndef _WIN32
+    std::unique_ptr<UnixSocketServer>           unix_server;
+    std::vector<std::unique_ptr<ShmRingServer>> shm_servers;
+    try {
+        if (!cfg.unix_socket.empty()) {
+            unix_server = std::make_unique<UnixSocketServer>(executor, cfg.unix_socket);
+            unix_server->start();
+            std::cout << col::green << "  [OK] Listening on unix:" << cfg.unix_socket
+                      << col::reset << "\n";
+        }
+        for (auto& name : cfg.shm_names) {
+            shm_servers.push_back(std::make_unique<ShmRingServer>(executor, name));
+            shm_servers.back()->start();
+            std::cout << col::green << "  [OK] Serving shm:" << name
+                      << col::reset << "\n";
+        }
+    } catch (const std::exception& ex) {
+        std::cout << col::red << "  [FAIL] " << ex.what() << col::reset << "\n";
+        return 1;
+    }
+
+    if (cfg.no_repl) {
+        int sig = 0;
+        sigwait(&stop_signals, &sig);
+        unix_server.reset();
+        shm_servers.clear();
+        try { store.save(cfg.snapshot_file); } catch (...) {}
+        std::cout << col::green << "  Snapshot saved. Goodbye!\n" << col::reset;
+        return 0;
+    }
+#else
+    if (!cfg.unix_socket.empty() || !cfg.shm_names.empty() || cfg.no_repl)
+        std::cout << col::yellow << "  [WARN] --unix-socket / --shm / --no-repl "
+                     "are not supported on Windows" << col::reset << "\n";
+#endif
+
     CommandParser parser;
     std::string   line;
 
@@ -178,13 +441,33 @@ int main(int argc, char* argv[]) {
             continue;
         }
 
+        // Timed like the executor; includes rendering the reply to the terminal.
+        KVStore::takeLockContended();
+        const uint64_t start = CycleClock::now();
+
         switch (cmd.type) {
             case CommandType::SET: {
-                std::string evicted = store.set(cmd.key, cmd.value, cmd.ttl);
-                std::cout << col::green << "  OK" << col::reset;
-                if (!evicted.empty())
-                    std::cout << col::grey << "  [evicted: " << evicted << "]" << col::reset;
-                if (cmd.ttl > 0)
+                SetResult r = store.set(cmd.key, cmd.value,
+                                        CommandExecutor::setOptionsOf(cmd));
+                if (cmd.get_old) {
+                    if (r.old_value)
+                        std::cout << col::green << "  \"" << *r.old_value << "\"" << col::reset;
+                    else
+                        std::cout << col::grey << "  (nil)" << col::reset;
+                } else if (r.applied) {
+                    std::cout << col::green << "  OK" << col::reset;
+                } else {
+                    std::cout << col::grey << "  (nil)" << col::reset;
+                }
+                if (!r.applied)
+                    std::cout << col::grey << "  [not set: key "
+                              << (cmd.nx ? "exists" : "missing") << "]" << col::reset;
+                if (!r.evicted.empty())
+                    std::cout << col::grey << "  [evicted: "
+                              << (r.evicted.size() == 1 ? r.evicted.front()
+                                                        : std::to_string(r.evicted.size()) + " keys")
+                              << "]" << col::reset;
+                if (r.applied && cmd.ttl > 0)
                     std::cout << col::grey << "  [TTL: " << cmd.ttl << "s]" << col::reset;
                 std::cout << "\n";
                 break;
@@ -197,6 +480,29 @@ int main(int argc, char* argv[]) {
                     std::cout << col::grey << "  (nil)" << col::reset << "\n";
                 break;
             }
+            case CommandType::GETS: {
+                auto val = store.gets(cmd.key);
+                if (val)
+                    std::cout << col::green << "  \"" << val->value << "\"" << col::reset
+                              << col::grey << "  (version " << val->version << ")"
+                              << col::reset << "\n";
+                else
+                    std::cout << col::grey << "  (nil)" << col::reset << "\n";
+                break;
+            }
+            case CommandType::CAS:
+                switch (store.cas(cmd.key, cmd.value, cmd.version, cmd.ttl)) {
+                    case LRUCache::CasResult::STORED:
+                        std::cout << col::green << "  STORED" << col::reset << "\n";
+                        break;
+                    case LRUCache::CasResult::EXISTS:
+                        std::cout << col::yellow << "  EXISTS  (modified since GETS)"
+                                  << col::reset << "\n";
+                        break;
+                    default:
+                        std::cout << col::grey << "  (key not found)" << col::reset << "\n";
+                }
+                break;
             case CommandType::DEL: {
                 bool existed = store.del(cmd.key);
                 if (existed)
@@ -205,6 +511,43 @@ int main(int argc, char* argv[]) {
                     std::cout << col::grey << "  (key not found)" << col::reset << "\n";
                 break;
             }
+            case CommandType::MGET: {
+                auto vals = store.mget(cmd.args);
+                for (size_t i = 0; i < vals.size(); ++i) {
+                    std::cout << "    " << col::cyan << (i + 1) << ") " << col::reset;
+                    if (vals[i])
+                        std::cout << col::green << "\"" << *vals[i] << "\"" << col::reset << "\n";
+                    else
+                        std::cout << col::grey << "(nil)" << col::reset << "\n";
+                }
+                break;
+            }
+            case CommandType::MSET: {
+                auto evicted = store.mset(CommandExecutor::pairsOf(cmd.args));
+                std::cout << col::green << "  OK" << col::reset;
+                if (!evicted.empty())
+                    std::cout << col::grey << "  [evicted: " << evicted.size()
+                              << " key(s)]" << col::reset;
+                std::cout << "\n";
+                break;
+            }
+            case CommandType::MDEL:
+            case CommandType::UNLINK: {
+                size_t n = cmd.type == CommandType::MDEL ? store.mdel(cmd.args)
+                                                         : store.unlink(cmd.args);
+                std::cout << (n ? col::green : col::grey) << "  (" << n
+                          << " deleted)" << col::reset << "\n";
+                break;
+            }
+            case CommandType::INCR:
+                try {
+                    long long v = store.incrBy(cmd.key, cmd.delta);
+                    std::cout << col::green << "  (integer) " << v << col::reset << "\n";
+                } catch (const std::exception& ex) {
+                    std::cout << col::red << "  (error) " << ex.what()
+                              << col::reset << "\n";
+                }
+                break;
             case CommandType::TTL: {
                 long long t = store.ttl(cmd.key);
                 if      (t == -2) std::cout << col::grey   << "  (key does not exist)" << col::reset << "\n";
@@ -226,12 +569,36 @@ int main(int argc, char* argv[]) {
                 break;
             }
             case CommandType::FLUSH:
-                store.flush();
+                store.flush(cmd.key == "ASYNC");
                 std::cout << col::yellow << "  (all keys flushed)" << col::reset << "\n";
                 break;
             case CommandType::STATS:
                 printStats(store.stats());
                 break;
+            case CommandType::INFO:
+                if (cmd.key.empty() || cmd.key == "stats")   printStats(store.stats());
+                if (cmd.key.empty() || cmd.key == "latency") printLatency(store);
+                if (cmd.key.empty() || cmd.key == "slabs")   printSlabs(store.stats().slabs);
+                break;
+            case CommandType::LATENCY:
+                if (cmd.key == "RESET") {
+                    store.resetLatency();
+                    std::cout << col::green << "  OK" << col::reset
+                              << col::grey << "  (latency histograms reset)" << col::reset << "\n";
+                } else {
+                    printLatency(store);
+                }
+                break;
+            case CommandType::SLOWLOG:
+                if (cmd.key == "RESET") {
+                    slowlog.reset();
+                    std::cout << col::green << "  OK" << col::reset << "\n";
+                } else if (cmd.key == "LEN") {
+                    std::cout << col::yellow << "  (integer) " << slowlog.length() << col::reset << "\n";
+                } else {
+                    printSlowLog(slowlog, static_cast<size_t>(cmd.delta));
+                }
+                break;
             case CommandType::SAVE:
                 try {
                     store.save(cfg.snapshot_file);
@@ -254,6 +621,10 @@ int main(int argc, char* argv[]) {
                 std::cout << col::red << "  Unknown command: \"" << cmd.raw
                           << "\". Type HELP." << col::reset << "\n";
         }
+
+        const uint64_t end = CycleClock::now();
+        if (end > start && slowlog.slow(end - start))
+            CommandExecutor::logSlow(slowlog, cmd, end - start);
     }
 
     // EOF / Ctrl+Z
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+
+/**
+ * MemoryUsage — byte cost model for maxmemory accounting
+ *
+ * Approximates what the allocator hands out, not what was requested. Each
+ * malloc'd block carries an 8-byte header and is rounded up to 16 bytes,
+ * with a 32-byte minimum (glibc / ptmalloc on 64-bit). A std::string only
+ * owns heap memory once it outgrows its 15-byte inline buffer (libstdc++
+ * SSO). Other allocators are close enough for an eviction budget. The
+ * benchmark's --memory mode prints this estimate next to the measured heap
+ * growth.
+ */
+struct MemoryUsage {
+    static constexpr size_t SSO_CAPACITY = 15;
+
+    // Bytes consumed by one heap allocation of `n` bytes.
+    static constexpr size_t chunk(size_t n) {
+        return n + 8 <= 32 ? 32 : (n + 8 + 15) & ~size_t(15);
+    }
+
+    // Heap bytes owned by `s` (0 while it fits in the inline buffer).
+    static size_t heap(const std::string& s) {
+        return s.capacity() > SSO_CAPACITY ? chunk(s.capacity() + 1) : 0;
+    }
+
+    // Node of a std::unordered_map<K, V> with cached hash codes.
+    template <typename K, typename V>
+    static constexpr size_t hashNode() {
+        return chunk(sizeof(void*) + sizeof(std::pair<const K, V>) + sizeof(size_t));
+    }
+
+    // Node of a std::set<T> / std::map (red-black tree: colour + 3 links).
+    template <typename T>
+    static constexpr size_t treeNode() { return chunk(4 * sizeof(void*) + sizeof(T)); }
+
+    // Bucket array of an unordered container.
+    static constexpr size_t buckets(size_t count) { return count ? chunk(count * sizeof(void*)) : 0; }
+};
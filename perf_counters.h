@@ -0,0 +1,176 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * PerfCounters — per-phase hardware/software counters via perf_event_open
+ *
+ * Counts, for the calling process and every thread it spawns after open():
+ *
+ *   cycles          CPU cycles
+ *   instructions    retired instructions (IPC = instructions / cycles)
+ *   l1d_misses      L1 data-cache read misses
+ *   llc_misses      last-level cache read misses
+ *   branch_misses   mispredicted branches
+ *   ctx_switches    context switches (software event)
+ *
+ * Each event is opened on its own with inherit=1, because the kernel rejects
+ * grouped reads of inherited counters. Counts from child threads are folded
+ * in when those threads exit, so call stop() only after joining the workers.
+ * If the PMU is oversubscribed, the kernel multiplexes events; values are
+ * scaled by time_enabled / time_running.
+ *
+ * Degradation: an event the kernel refuses with kernel+user counting (e.g.
+ * perf_event_paranoid = 2) is retried user-space only. Context switches
+ * happen in the kernel, so instead of a user-only event (which would always
+ * read 0) they fall back to getrusage() voluntary + involuntary switches. Any
+ * other event that still fails, for example in a VM without a virtual PMU, is
+ * marked unavailable and reported as -1. On non-Linux platforms nothing is
+ * available.
+ */
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, CTX_SWITCHES, COUNT };
+
+    struct Sample {
+        double values[COUNT];
+        bool   user_only = false;   // at least one event excludes kernel time
+
+        Sample() { for (auto& v : values) v = -1; }
+        bool   has(Event e)   const { return values[e] >= 0; }
+        bool   any()          const { for (double v : values) if (v >= 0) return true; return false; }
+        double perOp(Event e, uint64_t ops) const {
+            return has(e) && ops ? values[e] / static_cast<double>(ops) : -1;
+        }
+    };
+
+    static const char* name(Event e) {
+        static const char* names[COUNT] = {"cycles", "instructions", "l1d_misses",
+                                           "llc_misses", "branch_misses", "ctx_switches"};
+        return names[e];
+    }
+
+    PerfCounters() { for (auto& fd : fds_) fd = -1; }
+    ~PerfCounters() { close(); }
+    PerfCounters(const PerfCounters&)            = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Opens every event, disabled. Returns true if at least one opened; the
+    // reason for the last failure is left in error().
+    bool open() {
+#ifdef __linux__
+        close();
+        bool any = false;
+        for (int e = 0; e < COUNT; ++e) {
+            fds_[e] = openEvent(static_cast<Event>(e), /*user_only=*/false);
+            if (fds_[e] < 0 && e == CTX_SWITCHES) { any = true; continue; } // rusage fallback
+            if (fds_[e] < 0 && (errno == EACCES || errno == EPERM)) {
+                fds_[e] = openEvent(static_cast<Event>(e), /*user_only=*/true);
+                if (fds_[e] >= 0) user_only_ = true;
+            }
+            if (fds_[e] < 0) error_ = std::string(name(static_cast<Event>(e))) + ": "
+                                    + std::strerror(errno);
+            else any = true;
+        }
+        return any;
+#else
+        error_ = "perf_event_open is Linux-only";
+        return false;
+#endif
+    }
+
+    void start() {
+#ifdef __linux__
+        rusage_switches_ = rusageSwitches();
+        for (int fd : fds_) if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    Sample stop() {
+        Sample s;
+#ifdef __linux__
+        s.user_only = user_only_;
+        for (int e = 0; e < COUNT; ++e) {
+            if (fds_[e] < 0) continue;
+            ioctl(fds_[e], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t buf[3] = {0, 0, 0}; // value, time_enabled, time_running
+            if (::read(fds_[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) continue;
+            if (buf[2] == 0) { s.values[e] = 0; continue; }
+            s.values[e] = static_cast<double>(buf[0])
+                        * (static_cast<double>(buf[1]) / static_cast<double>(buf[2]));
+        }
+        if (fds_[CTX_SWITCHES] < 0)
+            s.values[CTX_SWITCHES] = static_cast<double>(rusageSwitches() - rusage_switches_);
+#endif
+        return s;
+    }
+
+    void close() {
+#ifdef __linux__
+        for (auto& fd : fds_) if (fd >= 0) { ::close(fd); fd = -1; }
+#endif
+        user_only_ = false;
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+#ifdef __linux__
+    static long rusageSwitches() {
+        rusage ru{};
+        return getrusage(RUSAGE_SELF, &ru) == 0 ? ru.ru_nvcsw + ru.ru_nivcsw : 0;
+    }
+
+    static int openEvent(Event e, bool user_only) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        switch (e) {
+            case CYCLES:
+                attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+            case INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case L1D_MISSES:
+                attr.type   = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case LLC_MISSES:
+                attr.type   = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case BRANCH_MISSES:
+                attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+            case CTX_SWITCHES:
+            case COUNT:
+                attr.type = PERF_TYPE_SOFTWARE; attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES; break;
+        }
+        attr.disabled       = 1;
+        attr.inherit        = 1;
+        attr.exclude_kernel = user_only ? 1 : 0;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0 /*this process*/,
+                                        -1 /*any cpu*/, -1 /*no group*/, 0));
+    }
+#endif
+
+    int         fds_[COUNT];
+    bool        user_only_ = false;
+    long        rusage_switches_ = 0;
+    std::string error_;
+};
@@ -0,0 +1,438 @@
+#pragma once
+#ifndef _WIN32
+#include "executor.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * SpscRing — single-producer / single-consumer byte ring in shared memory
+ *
+ * Layout: head_ (consumer cursor) and tail_ (producer cursor) are monotonic
+ * byte offsets on separate cache lines, followed by `capacity` data bytes.
+ * Each record is [4-byte length][payload], padded to 8 bytes. A record that
+ * would straddle the end is preceded by a PAD marker and written at offset 0,
+ * so payloads are always contiguous.
+ *
+ * Waiting: consumers spin briefly, then sleep on a futex keyed on seq_.
+ * Producers bump seq_ after publishing and only issue FUTEX_WAKE when the
+ * consumer advertised itself as sleeping, so the hot path is syscall-free.
+ * The futex is process-shared (no FUTEX_PRIVATE_FLAG) since the ring lives
+ * in a segment mapped by two processes. On non-Linux POSIX the sleep is a
+ * short nanosleep poll instead.
+ */
+class SpscRing {
+public:
+    static constexpr uint32_t PAD = 0xFFFFFFFFu;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "shared-memory ring requires address-free 64-bit atomics");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free,
+                  "shared-memory ring requires address-free 32-bit atomics");
+
+    static size_t bytesFor(size_t capacity) { return sizeof(SpscRing) + capacity; }
+
+    // Placement-initialises a ring at `mem` (segment creator only).
+    static SpscRing* create(void* mem, size_t capacity) {
+        auto* r = new (mem) SpscRing();
+        r->capacity_ = capacity;
+        return r;
+    }
+
+    static SpscRing* attach(void* mem) { return static_cast<SpscRing*>(mem); }
+
+    // Largest payload that fits: leave room for the header and a wrap pad.
+    size_t maxMessage() const { return capacity_ / 2 - 8; }
+
+    // Producer: append one message; spins while the ring is full. Returns
+    // false if the message can never fit, or if `running` turns false while
+    // waiting for room (the consumer may never read again).
+    bool push(const char* data, size_t len, const std::atomic<bool>* running = nullptr) {
+        if (len > maxMessage()) return false;
+        size_t   rec  = align8(4 + len);
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        size_t   off  = static_cast<size_t>(tail % capacity_);
+        size_t   need = (off + rec > capacity_) ? (capacity_ - off) + rec : rec;
+
+        while (capacity_ - (tail - head_.load(std::memory_order_acquire)) < need) {
+            if (running && !running->load(std::memory_order_relaxed)) return false;
+            std::this_thread::yield();
+        }
+
+        if (off + rec > capacity_) {
+            std::memcpy(data_() + off, &PAD, 4);
+            tail += capacity_ - off;
+            off   = 0;
+        }
+        uint32_t len32 = static_cast<uint32_t>(len);
+        std::memcpy(data_() + off, &len32, 4);
+        std::memcpy(data_() + off + 4, data, len);
+        tail_.store(tail + rec, std::memory_order_seq_cst);
+
+        seq_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_seq_cst)) wake();
+        return true;
+    }
+
+    // Consumer: pop one message into `out`; returns false if the ring is empty.
+    bool tryPop(std::string& out) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            if (head == tail_.load(std::memory_order_acquire)) return false;
+            size_t   off = static_cast<size_t>(head % capacity_);
+            uint32_t len;
+            std::memcpy(&len, data_() + off, 4);
+            if (len == PAD) {
+                head += capacity_ - off;
+                head_.store(head, std::memory_order_release);
+                continue;
+            }
+            out.assign(data_() + off + 4, len);
+            head_.store(head + align8(4 + len), std::memory_order_release);
+            return true;
+        }
+    }
+
+    // Consumer: pop one message, spinning `spin` polls and then sleeping until
+    // a producer wakes us or `timeout` passes. Returns false on timeout.
+    bool pop(std::string& out, int spin, std::chrono::milliseconds timeout) {
+        for (int i = 0; i < spin; ++i)
+            if (tryPop(out)) return true;
+
+        uint32_t seen = seq_.load(std::memory_order_seq_cst);
+        sleeping_.store(1, std::memory_order_seq_cst);
+        bool got = tryPop(out);
+        if (!got) {
+            sleepOn(seen, timeout);
+            got = tryPop(out);
+        }
+        sleeping_.store(0, std::memory_order_relaxed);
+        return got;
+    }
+
+    // Wakes a sleeping consumer unconditionally (used on shutdown).
+    void wake() {
+#ifdef __linux__
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAKE, 1,
+                  nullptr, nullptr, 0);
+#endif
+    }
+
+private:
+    SpscRing() = default;
+
+    static size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+    char* data_() { return reinterpret_cast<char*>(this + 1); }
+
+    void sleepOn(uint32_t seen, std::chrono::milliseconds timeout) {
+#ifdef __linux__
+        timespec ts{};
+        ts.tv_sec  = static_cast<time_t>(timeout.count() / 1000);
+        ts.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1'000'000);
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAIT, seen,
+                  &ts, nullptr, 0);
+#else
+        (void)seen;
+        (void)timeout;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+    }
+
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    alignas(64) std::atomic<uint32_t> seq_{0};
+    std::atomic<uint32_t>             sleeping_{0};
+    size_t                            capacity_ = 0;
+};
+
+/**
+ * ShmSegment — one shared-memory segment holding a request and a reply ring.
+ *
+ * Layout: [header][request SpscRing + data][reply SpscRing + data]
+ * `server` holds the creating server's pid, cleared when it unmaps the
+ * segment. Exactly one client may attach at a time (the rings are SPSC);
+ * `client` holds the attached client's pid (0 = none). Both are leases: a
+ * process that is gone no longer holds the segment. Each attach bumps
+ * `epoch`, which the client puts in its request tags (see ShmRingServer).
+ */
+struct ShmSegmentHeader {
+    static constexpr uint32_t MAGIC   = 0x43535352; // 'CSSR'
+    static constexpr uint32_t VERSION = 4;
+
+    uint32_t              magic   = MAGIC;
+    uint32_t              version = VERSION;
+    uint64_t              ring_capacity = 0;
+    std::atomic<uint32_t> server{0};
+    std::atomic<uint32_t> client{0};
+    std::atomic<uint32_t> epoch{0};
+};
+
+// True while process `pid` exists; 0 is never alive. EPERM means it exists
+// but belongs to another user.
+inline bool processAlive(uint32_t pid) {
+    return pid != 0 && (::kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH);
+}
+
+class ShmMapping {
+public:
+    // Creates (server) or opens (client) the named POSIX shm segment. An
+    // existing segment is replaced only if its server is gone.
+    // @throws std::runtime_error on failure, or if a live server holds `name`.
+    ShmMapping(const std::string& name, size_t ring_capacity, bool create)
+        : name_(name), owner_(create)
+    {
+        int flags = create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR;
+        int fd = ::shm_open(name_.c_str(), flags, 0600);
+        if (fd < 0 && create && errno == EEXIST) {
+            if (servedByLiveProcess(name_))
+                throw std::runtime_error("Segment is served by a running process: " + name_);
+            ::shm_unlink(name_.c_str()); // stale segment from a crash
+            fd = ::shm_open(name_.c_str(), flags, 0600);
+        }
+        if (fd < 0) throw std::runtime_error("shm_open " + name_ + ": " + std::strerror(errno));
+
+        if (create) {
+            size_ = layoutSize(ring_capacity);
+            if (::ftruncate(fd, static_cast<off_t>(size_)) < 0) {
+                ::close(fd);
+                throw std::runtime_error("ftruncate " + name_ + ": " + std::strerror(errno));
+            }
+        } else {
+            struct stat st{};
+            if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(ShmSegmentHeader)) {
+                ::close(fd);
+                throw std::runtime_error("Not a ChronoStore segment: " + name_);
+            }
+            size_ = static_cast<size_t>(st.st_size);
+        }
+
+        base_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base_ == MAP_FAILED) throw std::runtime_error("mmap " + name_ + ": " + std::strerror(errno));
+
+        if (create) {
+            auto* h = new (base_) ShmSegmentHeader();
+            h->ring_capacity = ring_capacity;
+            h->server.store(static_cast<uint32_t>(::getpid()));
+            request_ = SpscRing::create(ringMem(0), ring_capacity);
+            reply_   = SpscRing::create(ringMem(1), ring_capacity);
+        } else {
+            auto* h = header();
+            if (h->magic != ShmSegmentHeader::MAGIC || h->version != ShmSegmentHeader::VERSION ||
+                layoutSize(h->ring_capacity) != size_) {
+                ::munmap(base_, size_);
+                throw std::runtime_error("Not a ChronoStore segment: " + name_);
+            }
+            request_ = SpscRing::attach(ringMem(0));
+            reply_   = SpscRing::attach(ringMem(1));
+        }
+    }
+
+    ~ShmMapping() {
+        if (base_ && base_ != MAP_FAILED) {
+            if (owner_) header()->server.store(0);
+            ::munmap(base_, size_);
+        }
+        if (owner_) ::shm_unlink(name_.c_str());
+    }
+
+    ShmMapping(const ShmMapping&)            = delete;
+    ShmMapping& operator=(const ShmMapping&) = delete;
+
+    ShmSegmentHeader* header()  { return static_cast<ShmSegmentHeader*>(base_); }
+    SpscRing&         request() { return *request_; }
+    SpscRing&         reply()   { return *reply_; }
+
+private:
+    // True if the existing segment `name` is ours and its server still runs.
+    static bool servedByLiveProcess(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        bool live = false;
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ShmSegmentHeader)) {
+            void* p = ::mmap(nullptr, sizeof(ShmSegmentHeader), PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                auto* h = static_cast<const ShmSegmentHeader*>(p);
+                live = h->magic == ShmSegmentHeader::MAGIC &&
+                       h->version == ShmSegmentHeader::VERSION && processAlive(h->server.load());
+                ::munmap(p, sizeof(ShmSegmentHeader));
+            }
+        }
+        ::close(fd);
+        return live;
+    }
+
+    static size_t headerBytes() { return (sizeof(ShmSegmentHeader) + 63) & ~size_t(63); }
+    static size_t layoutSize(size_t cap) { return headerBytes() + 2 * SpscRing::bytesFor(cap); }
+
+    void* ringMem(int i) {
+        size_t ring = SpscRing::bytesFor(header()->ring_capacity);
+        return static_cast<char*>(base_) + headerBytes() + static_cast<size_t>(i) * ring;
+    }
+
+    std::string name_;
+    bool        owner_;
+    size_t      size_  = 0;
+    void*       base_  = nullptr;
+    SpscRing*   request_ = nullptr;
+    SpscRing*   reply_   = nullptr;
+};
+
+/**
+ * ShmRingServer — serves one shared-memory segment from a dedicated thread.
+ *
+ * The thread polls the request ring (spinning first, then futex-waiting),
+ * runs each request through CommandExecutor and pushes the RESP reply onto
+ * the reply ring. A co-located GET therefore costs two cache-line handoffs
+ * and a hash lookup rather than a socket round trip.
+ *
+ * Framing: every request ends with a TAG_BYTES tag that the server copies
+ * onto the end of its reply. A client that takes over a segment skips
+ * replies whose tag is not its own, including one owed to a client that
+ * died mid-request.
+ */
+class ShmRingServer {
+public:
+    static constexpr size_t DEFAULT_RING_BYTES = 1 << 20; // 1 MiB per direction
+    static constexpr int    SPIN_POLLS         = 2000;
+    static constexpr size_t TAG_BYTES          = sizeof(uint64_t);
+
+    ShmRingServer(const CommandExecutor& exec, std::string name,
+                  size_t ring_bytes = DEFAULT_RING_BYTES)
+        : exec_(exec), name_(std::move(name)), ring_bytes_(ring_bytes) {}
+
+    ~ShmRingServer() { stop(); }
+
+    ShmRingServer(const ShmRingServer&)            = delete;
+    ShmRingServer& operator=(const ShmRingServer&) = delete;
+
+    // Creates the segment and starts the polling thread.
+    // @throws std::runtime_error if the segment cannot be created.
+    void start() {
+        mapping_ = std::make_unique<ShmMapping>(name_, ring_bytes_, true);
+        running_ = true;
+        worker_  = std::thread(&ShmRingServer::run, this);
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) return;
+        mapping_->request().wake();
+        if (worker_.joinable()) worker_.join();
+        mapping_.reset();
+    }
+
+    const std::string& name() const { return name_; }
+
+private:
+    void run() {
+        std::string req;
+        while (running_) {
+            if (!mapping_->request().pop(req, SPIN_POLLS, std::chrono::milliseconds(100)))
+                continue;
+            if (req.size() < TAG_BYTES) continue; // not a framed request
+            char tag[TAG_BYTES];
+            std::memcpy(tag, req.data() + req.size() - TAG_BYTES, TAG_BYTES);
+            req.resize(req.size() - TAG_BYTES);
+
+            bool close = false;
+            std::string reply = exec_.execute(req, close);
+            reply.append(tag, TAG_BYTES);
+            if (!mapping_->reply().push(reply.data(), reply.size(), &running_)) {
+                if (!running_) break; // stopped while the client was not reading
+                reply = CommandExecutor::error("reply too large for shared-memory ring");
+                reply.append(tag, TAG_BYTES);
+                mapping_->reply().push(reply.data(), reply.size(), &running_);
+            }
+        }
+    }
+
+    const CommandExecutor&      exec_;
+    std::string                 name_;
+    size_t                      ring_bytes_;
+    std::unique_ptr<ShmMapping> mapping_;
+    std::atomic<bool>           running_{false};
+    std::thread                 worker_;
+};
+
+/**
+ * ShmRingClient — attaches to a ShmRingServer segment.
+ *
+ * request() posts one inline command and blocks for its RESP reply.
+ * Only one ShmRingClient may be attached to a segment at a time; the
+ * segment of a client that died without detaching can be taken over.
+ */
+class ShmRingClient {
+public:
+    // @throws std::runtime_error if a live client is attached already.
+    explicit ShmRingClient(const std::string& name) : name_(name), mapping_(name, 0, false) {
+        const auto self = static_cast<uint32_t>(::getpid());
+        auto& client = mapping_.header()->client;
+        uint32_t holder = 0;
+        while (!client.compare_exchange_strong(holder, self)) {
+            if (processAlive(holder))
+                throw std::runtime_error("Segment already has a client: " + name);
+            // The holder exited without detaching; retry against its pid.
+        }
+        epoch_ = mapping_.header()->epoch.fetch_add(1) + 1;
+    }
+
+    ~ShmRingClient() { mapping_.header()->client.store(0); }
+
+    ShmRingClient(const ShmRingClient&)            = delete;
+    ShmRingClient& operator=(const ShmRingClient&) = delete;
+
+    // Waits for the reply as long as the server runs; checks every 100 ms.
+    // @throws std::runtime_error if the request exceeds the ring size, or
+    //         the server stops or exits before replying.
+    std::string request(const std::string& line) {
+        constexpr size_t TAG_BYTES = ShmRingServer::TAG_BYTES;
+        const uint64_t tag = (uint64_t(epoch_) << 32) | ++seq_;
+        frame_.assign(line).append(reinterpret_cast<const char*>(&tag), TAG_BYTES);
+        if (!mapping_.request().push(frame_.data(), frame_.size()))
+            throw std::runtime_error("Request too large for shared-memory ring");
+
+        std::string reply;
+        for (;;) {
+            if (mapping_.reply().pop(reply, ShmRingServer::SPIN_POLLS,
+                                     std::chrono::milliseconds(100))) {
+                if (reply.size() >= TAG_BYTES &&
+                    std::memcmp(reply.data() + reply.size() - TAG_BYTES, &tag, TAG_BYTES) == 0) {
+                    reply.resize(reply.size() - TAG_BYTES);
+                    return reply;
+                }
+                continue; // owed to an earlier client of this segment
+            }
+            if (!processAlive(mapping_.header()->server.load()))
+                throw std::runtime_error("Shared-memory server is gone: " + name_);
+        }
+    }
+
+private:
+    std::string name_;
+    ShmMapping  mapping_;
+    uint32_t    epoch_ = 0; // this attach's generation
+    uint32_t    seq_   = 0;
+    std::string frame_;     // request + tag, reused across calls
+};
+
+#endif // !_WIN32
@@ -0,0 +1,403 @@
+#pragma once
+#include "memory_usage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+/**
+ * SlabClassStats — one size class of the SlabPool, as reported by INFO slabs.
+ */
+struct SlabClassStats {
+    size_t size     = 0; // object bytes
+    size_t reserved = 0; // bytes of slabs carved into this class
+    size_t in_use   = 0; // objects handed out
+    size_t free     = 0; // carved objects not handed out (free lists, caches)
+};
+
+/**
+ * SlabPool — size-class slab allocator for cache entries
+ *
+ * Sizes up to MAX_SIZE round up to one of 56 classes: 16-byte steps to
+ * 128, then eight classes per doubling (144, 160, …, 256, 288, …, 8192),
+ * so rounding wastes at most 12.5%. Slabs are 64 KiB, aligned to their
+ * size, with a small header (Slab) in front of the objects, so any
+ * object's slab is its address masked. A freed object goes on its class's
+ * free list and is reused only by the same class. Larger requests go to
+ * operator new.
+ *
+ * Per-thread caches: each thread keeps a small magazine of free objects per
+ * class. allocate() is a pop from it, and deallocate() is a push. Only an
+ * empty or full magazine takes the class mutex, to move half a magazine
+ * from or to the global free list (or to bump-allocate from the current
+ * slab). Every object also counts itself in its slab's `live` count.
+ *
+ * Defragmentation: beginDefrag() marks each class's sparsest slabs as
+ * draining, as many as the class's other slabs have room to absorb. Their
+ * free objects leave the free list, and objects freed from them later are
+ * parked rather than reused. The owner moves its live objects out (see
+ * LRUCache::defrag), and a slab whose every object is parked is released:
+ * its pages go back to the OS (madvise) and the empty slab can serve any
+ * class. endDefrag() returns the rest to service. Objects held elsewhere
+ * (another store, a thread's magazine) only delay a slab to the next cycle.
+ * The pool runs one cycle at a time, shared by every store defragmenting
+ * it: a beginDefrag() during a cycle joins it, and the cycle ends with the
+ * last participant's endDefrag().
+ *
+ * One pool per process (instance()), deliberately leaked so thread caches
+ * can flush into it from thread-exit destructors at any point.
+ */
+class SlabPool {
+public:
+    static constexpr size_t MAX_SIZE   = 8 * 1024;
+    static constexpr size_t CLASSES    = 56;
+    static constexpr size_t SLAB_BYTES = 64 * 1024;
+    static constexpr size_t MAGAZINE   = 32;        // per-thread cache, small classes
+
+    static SlabPool& instance() {
+        static SlabPool* pool = new SlabPool();
+        return *pool;
+    }
+
+    // Index of the class serving `bytes` (1 ≤ bytes ≤ MAX_SIZE).
+    static constexpr size_t classOf(size_t bytes) {
+        if (bytes <= 128) return bytes == 0 ? 0 : (bytes - 1) / 16;
+        const int k = 63 - __builtin_clzll(bytes - 1);   // 2^k < bytes ≤ 2^(k+1), step 2^(k-3)
+        return static_cast<size_t>(k - 7) * 8 + ((bytes - 1) >> (k - 3));
+    }
+
+    static constexpr size_t classSize(size_t cls) {
+        if (cls < 8) return (cls + 1) * 16;
+        const size_t k = 7 + (cls - 8) / 8;
+        return (size_t(1) << k) + ((cls - 8) % 8 + 1) * (size_t(1) << (k - 3));
+    }
+
+    // Bytes an allocation of `bytes` really consumes (for MemoryUsage-style
+    // accounting): its class size, or a malloc chunk above MAX_SIZE.
+    static constexpr size_t bytesFor(size_t bytes) {
+        return bytes <= MAX_SIZE ? classSize(classOf(bytes)) : MemoryUsage::chunk(bytes);
+    }
+
+    void* allocate(size_t bytes) {
+        if (bytes > MAX_SIZE) return ::operator new(bytes);
+        const size_t cls = classOf(bytes);
+        ThreadCache& tc  = threadCache();
+        while (true) {
+            if (tc.count[cls] == 0) tc.count[cls] = refill(tc, cls);
+            void* p = tc.slots[cls][--tc.count[cls]];
+            Slab* s = slabOf(p);
+            if (!s->draining.load(std::memory_order_relaxed)) {
+                s->live.fetch_add(1, std::memory_order_relaxed);
+                return p;
+            }
+            park(cls, s, p); // cached before its slab started draining
+        }
+    }
+
+    void deallocate(void* p, size_t bytes) noexcept {
+        if (bytes > MAX_SIZE) { ::operator delete(p); return; }
+        const size_t cls = classOf(bytes);
+        Slab* s = slabOf(p);
+        s->live.fetch_sub(1, std::memory_order_relaxed);
+        if (s->draining.load(std::memory_order_relaxed)) { park(cls, s, p); return; }
+        ThreadCache& tc = threadCache();
+        if (tc.count[cls] == magazine(cls)) drain(tc, cls, tc.count[cls] / 2);
+        tc.slots[cls][tc.count[cls]++] = p;
+    }
+
+    // True if `p`, returned by allocate(bytes), should be moved elsewhere.
+    static bool draining(const void* p, size_t bytes) {
+        return bytes <= MAX_SIZE && slabOf(p)->draining.load(std::memory_order_relaxed);
+    }
+
+    // Starts or joins the defragmentation cycle; returns the number of slabs
+    // draining. Every call that returns non-zero must be paired with an
+    // endDefrag(); one that returns 0 starts nothing.
+    size_t beginDefrag() {
+        std::lock_guard<std::mutex> cycle(defrag_mutex_);
+        if (defrag_users_ > 0) {
+            ++defrag_users_;
+            return defrag_slabs_;
+        }
+        size_t total = 0;
+        for (size_t c = 0; c < CLASSES; ++c) {
+            Class& k = classes_[c];
+            std::lock_guard<std::mutex> lock(k.mutex);
+            const uint32_t cap = capacity(c);
+            std::vector<std::pair<uint32_t, Slab*>> sparse; // (live, slab), current excluded
+            size_t room = k.current ? cap - k.current->live.load(std::memory_order_relaxed) : 0;
+            for (Slab* s : k.slabs) {
+                if (s == k.current) continue;
+                const uint32_t live = s->live.load(std::memory_order_relaxed);
+                room += cap - live;
+                if (live * 4 < cap * 3) sparse.emplace_back(live, s);
+            }
+            std::sort(sparse.begin(), sparse.end(),
+                      [](const auto& a, const auto& b) { return a.first < b.first; });
+            // Sparsest first, while the slabs left behind can take their objects.
+            size_t moving = 0, chosen = 0;
+            for (auto& [live, s] : sparse) {
+                if (moving + live > room - (cap - live)) break;
+                room   -= cap - live;
+                moving += live;
+                s->draining.store(true, std::memory_order_relaxed);
+                ++chosen;
+            }
+            if (chosen == 0) continue;
+            total += chosen;
+            void** link = &k.free_list; // unlink the draining slabs' free objects
+            while (*link) {
+                void* p = *link;
+                Slab* s = slabOf(p);
+                if (!s->draining.load(std::memory_order_relaxed)) { link = static_cast<void**>(p); continue; }
+                *link = *static_cast<void**>(p);
+                --k.free_count;
+                parkLocked(k, s, p);
+            }
+        }
+        defrag_slabs_ = total;
+        if (total) defrag_users_ = 1;
+        return total;
+    }
+
+    // Leaves the cycle. The last participant ends it: slabs that could not
+    // be emptied go back into service.
+    void endDefrag() {
+        std::lock_guard<std::mutex> cycle(defrag_mutex_);
+        if (defrag_users_ == 0 || --defrag_users_ > 0) return;
+        for (size_t c = 0; c < CLASSES; ++c) {
+            Class& k = classes_[c];
+            std::lock_guard<std::mutex> lock(k.mutex);
+            for (Slab* s : k.slabs) {
+                if (!s->draining.load(std::memory_order_relaxed)) continue;
+                s->draining.store(false, std::memory_order_relaxed);
+                while (s->parked_list) {
+                    void* p        = s->parked_list;
+                    s->parked_list = *static_cast<void**>(p);
+                    *static_cast<void**>(p) = k.free_list;
+                    k.free_list = p;
+                    ++k.free_count;
+                }
+                s->parked = 0;
+            }
+        }
+    }
+
+    // Slab bytes released to the OS by defragmentation, ever.
+    size_t releasedBytes() const { return released_.load(std::memory_order_relaxed); }
+
+    // Classes that own at least one slab. Live counts are read without
+    // stopping allocators, so a busy pool's figures are approximate.
+    std::vector<SlabClassStats> stats() const {
+        std::vector<SlabClassStats> out;
+        for (size_t c = 0; c < CLASSES; ++c) {
+            const Class& k = classes_[c];
+            std::lock_guard<std::mutex> lock(k.mutex);
+            if (k.slabs.empty()) continue;
+            SlabClassStats s;
+            s.size     = classSize(c);
+            s.reserved = k.slabs.size() * SLAB_BYTES;
+            size_t carved = 0;
+            for (const Slab* slab : k.slabs) {
+                carved   += slab->carved;
+                s.in_use += slab->live.load(std::memory_order_relaxed);
+            }
+            s.free = carved > s.in_use ? carved - s.in_use : 0;
+            out.push_back(s);
+        }
+        return out;
+    }
+
+    // Slab bytes reserved per byte handed out (1.0 = no waste).
+    static double fragmentation(const std::vector<SlabClassStats>& classes) {
+        size_t reserved = 0, used = 0;
+        for (auto& c : classes) { reserved += c.reserved; used += c.in_use * c.size; }
+        return used ? static_cast<double>(reserved) / static_cast<double>(used) : 1.0;
+    }
+
+private:
+    static constexpr size_t HEADER = 64; // Slab, padded; keeps objects 16-byte aligned
+
+    // Header at the start of every slab. `live` counts objects handed out;
+    // the rest is guarded by the class mutex (draining is also read without
+    // it, as a hint).
+    struct Slab {
+        std::atomic<uint32_t> live{0};
+        std::atomic<bool>     draining{false};
+        uint32_t              carved      = 0;       // objects bump-allocated so far
+        uint32_t              parked      = 0;       // draining: objects set aside
+        void*                 parked_list = nullptr;
+    };
+    static_assert(sizeof(Slab) <= HEADER, "slab header");
+
+    struct Class {
+        mutable std::mutex  mutex;
+        void*               free_list  = nullptr; // intrusive: first word links to the next
+        size_t              free_count = 0;
+        Slab*               current    = nullptr; // slab being bump-allocated
+        std::vector<Slab*>  slabs;
+    };
+
+    struct ThreadCache {
+        void*    slots[CLASSES][MAGAZINE];
+        uint32_t count[CLASSES] = {};
+
+        ~ThreadCache() {
+            for (size_t c = 0; c < CLASSES; ++c) instance().drain(*this, c, count[c]);
+        }
+    };
+
+    SlabPool() = default;
+
+    static ThreadCache& threadCache() {
+        thread_local ThreadCache tc;
+        return tc;
+    }
+
+    static Slab* slabOf(const void* p) {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(p) & ~(SLAB_BYTES - 1));
+    }
+
+    static constexpr uint32_t capacity(size_t cls) {
+        return static_cast<uint32_t>((SLAB_BYTES - HEADER) / classSize(cls));
+    }
+
+    // Big objects cache fewer: a magazine holds at most ~64 KiB.
+    static constexpr uint32_t magazine(size_t cls) {
+        return static_cast<uint32_t>(std::clamp<size_t>(SLAB_BYTES / classSize(cls), 4, MAGAZINE));
+    }
+
+    // Fills half of an empty magazine; returns the new count.
+    uint32_t refill(ThreadCache& tc, size_t cls) {
+        Class& k = classes_[cls];
+        const size_t size = classSize(cls);
+        const uint32_t want = magazine(cls) / 2;
+        uint32_t n = 0;
+        std::lock_guard<std::mutex> lock(k.mutex);
+        while (n < want && k.free_list) {
+            void* p     = k.free_list;
+            k.free_list = *static_cast<void**>(p);
+            --k.free_count;
+            tc.slots[cls][n++] = p;
+        }
+        while (n < want) {
+            if (!k.current || k.current->carved == capacity(cls)) {
+                k.current = newSlab();
+                k.slabs.push_back(k.current);
+            }
+            char* base = reinterpret_cast<char*>(k.current) + HEADER;
+            tc.slots[cls][n++] = base + size * k.current->carved++;
+        }
+        return n;
+    }
+
+    // Returns the top `n` cached objects to the class.
+    void drain(ThreadCache& tc, size_t cls, uint32_t n) {
+        Class& k = classes_[cls];
+        std::lock_guard<std::mutex> lock(k.mutex);
+        for (uint32_t i = 0; i < n; ++i) {
+            void* p = tc.slots[cls][--tc.count[cls]];
+            Slab* s = slabOf(p);
+            if (s->draining.load(std::memory_order_relaxed)) { parkLocked(k, s, p); continue; }
+            *static_cast<void**>(p) = k.free_list;
+            k.free_list = p;
+            ++k.free_count;
+        }
+    }
+
+    void park(size_t cls, Slab* s, void* p) {
+        Class& k = classes_[cls];
+        std::lock_guard<std::mutex> lock(k.mutex);
+        if (s->draining.load(std::memory_order_relaxed)) { parkLocked(k, s, p); return; }
+        *static_cast<void**>(p) = k.free_list; // the cycle ended meanwhile
+        k.free_list = p;
+        ++k.free_count;
+    }
+
+    // Sets `p` aside; once every object of `s` is, the slab is released.
+    void parkLocked(Class& k, Slab* s, void* p) {
+        *static_cast<void**>(p) = s->parked_list;
+        s->parked_list = p;
+        if (++s->parked < s->carved) return;
+        k.slabs.erase(std::find(k.slabs.begin(), k.slabs.end(), s));
+        if (k.current == s) k.current = nullptr;
+        s->~Slab();
+#ifndef _WIN32
+        madvise(s, SLAB_BYTES, MADV_DONTNEED);
+#endif
+        released_.fetch_add(SLAB_BYTES, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(empty_mutex_);
+        empty_.push_back(s);
+    }
+
+    // An empty slab, released earlier by any class, or fresh memory.
+    Slab* newSlab() {
+        void* mem = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(empty_mutex_);
+            if (!empty_.empty()) { mem = empty_.back(); empty_.pop_back(); }
+        }
+        if (!mem) mem = mapSlab();
+        return new (mem) Slab();
+    }
+
+    // SLAB_BYTES aligned to SLAB_BYTES. Slabs are never unmapped.
+    static void* mapSlab() {
+#ifndef _WIN32
+        // Over-map by one slab, then trim both ends to the aligned middle.
+        void* raw = mmap(nullptr, 2 * SLAB_BYTES, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) throw std::bad_alloc();
+        const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+        const uintptr_t base  = (start + SLAB_BYTES - 1) & ~(SLAB_BYTES - 1);
+        if (base > start) munmap(raw, base - start);
+        munmap(reinterpret_cast<void*>(base + SLAB_BYTES), SLAB_BYTES - (base - start));
+        return reinterpret_cast<void*>(base);
+#else
+        return ::operator new(SLAB_BYTES, std::align_val_t(SLAB_BYTES));
+#endif
+    }
+
+    Class               classes_[CLASSES];
+    std::mutex          empty_mutex_;
+    std::vector<Slab*>  empty_;
+    std::atomic<size_t> released_{0};
+    std::mutex          defrag_mutex_;     // taken before any class mutex
+    size_t              defrag_users_ = 0; // stores in the current cycle
+    size_t              defrag_slabs_ = 0; //   and the slabs it drains
+};
+
+static_assert(SlabPool::classOf(SlabPool::MAX_SIZE) == SlabPool::CLASSES - 1, "class table");
+static_assert(SlabPool::classSize(SlabPool::classOf(129)) == 144, "class table");
+
+/**
+ * SlabAllocator<T> — standard allocator over SlabPool::instance(), for the
+ * cache's list, index and value buffers. Stateless: all instances compare
+ * equal, so containers can splice and swap freely.
+ */
+template <typename T>
+struct SlabAllocator {
+    using value_type = T;
+    static_assert(alignof(T) <= 16, "slab objects are 16-byte aligned");
+
+    SlabAllocator() noexcept = default;
+    template <typename U> SlabAllocator(const SlabAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(SlabPool::instance().allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        SlabPool::instance().deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U> bool operator==(const SlabAllocator<U>&) const noexcept { return true; }
+    template <typename U> bool operator!=(const SlabAllocator<U>&) const noexcept { return false; }
+};
@@ -0,0 +1,161 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * SlowLog — bounded, lock-free log of commands that ran over a threshold
+ *
+ * The dispatch layer (REPL, socket / shm executor) times each command and
+ * calls slow(ticks). Under the threshold that is one compare and nothing
+ * else: no allocation, no shared writes. Over it, record() claims a ticket
+ * with one fetch_add and writes the entry into slot ticket % capacity.
+ *
+ * Every slot field is a relaxed atomic, and each slot is guarded by a
+ * seqlock word. A writer CASes the sequence from "complete" to
+ * 2·ticket+1 and publishes 2·ticket+2 when done. If another writer is
+ * still in the slot (a full lap behind or ahead), the entry is dropped
+ * rather than waiting. Readers take entries whose sequence is 2·ticket+2
+ * before and after the copy, and skip anything torn or overwritten.
+ *
+ * RESET moves a floor ticket forward instead of clearing slots, so it never
+ * races writers.
+ */
+class SlowLog {
+public:
+    static constexpr size_t KEY_BYTES = 48;   // longer keys are cut and marked "..."
+    static constexpr size_t CMD_BYTES = 16;
+
+    struct Entry {
+        uint64_t    id = 0;            // monotonically increasing
+        int64_t     timestamp_us = 0;  // wall clock (unix epoch) at completion
+        uint64_t    duration_us  = 0;
+        std::string command;
+        std::string key;               // possibly truncated
+        uint64_t    value_bytes = 0;   // total value payload of the command
+        bool        contended   = false; // waited for the store lock
+    };
+
+    // threshold_ticks: minimum duration to log, in the caller's tick unit
+    // (CycleClock), or negative to disable. ns_per_tick converts for display.
+    SlowLog(size_t capacity, int64_t threshold_ticks, double ns_per_tick)
+        : capacity_(std::max<size_t>(1, capacity)),
+          threshold_(threshold_ticks), ns_per_tick_(ns_per_tick),
+          slots_(new Slot[capacity_]) {}
+
+    bool slow(uint64_t ticks) const {
+        return threshold_ >= 0 && ticks >= static_cast<uint64_t>(threshold_);
+    }
+
+    void record(const std::string& command, const std::string& key, uint64_t value_bytes,
+                uint64_t ticks, bool contended) {
+        const uint64_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        Slot& s = slots_[ticket % capacity_];
+
+        uint64_t seq = s.seq.load(std::memory_order_relaxed);
+        if ((seq & 1) || seq > 2 * ticket ||
+            !s.seq.compare_exchange_strong(seq, 2 * ticket + 1, std::memory_order_acquire))
+            return; // slot busy with another writer — drop this entry
+        std::atomic_thread_fence(std::memory_order_release);
+
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        s.timestamp_us.store(std::chrono::duration_cast<std::chrono::microseconds>(now).count(),
+                             std::memory_order_relaxed);
+        s.duration_us.store(static_cast<uint64_t>(static_cast<double>(ticks) * ns_per_tick_ / 1000.0),
+                            std::memory_order_relaxed);
+        s.value_bytes.store(value_bytes, std::memory_order_relaxed);
+        s.contended.store(contended, std::memory_order_relaxed);
+        s.key_len.store(key.size(), std::memory_order_relaxed);
+        storeText(s.command, CMD_BYTES, command);
+        storeText(s.key, KEY_BYTES, key);
+
+        s.seq.store(2 * ticket + 2, std::memory_order_release);
+    }
+
+    // Newest first, at most `count` entries.
+    std::vector<Entry> get(size_t count) const {
+        std::vector<Entry> out;
+        const uint64_t head  = next_.load(std::memory_order_acquire);
+        const uint64_t floor = std::max(floor_.load(std::memory_order_acquire),
+                                        head > capacity_ ? head - capacity_ : uint64_t(0));
+        for (uint64_t t = head; t > floor && out.size() < count; --t) {
+            const uint64_t ticket = t - 1;
+            const Slot& s = slots_[ticket % capacity_];
+            if (s.seq.load(std::memory_order_acquire) != 2 * ticket + 2) continue;
+
+            Entry e;
+            e.id           = ticket;
+            e.timestamp_us = s.timestamp_us.load(std::memory_order_relaxed);
+            e.duration_us  = s.duration_us.load(std::memory_order_relaxed);
+            e.value_bytes  = s.value_bytes.load(std::memory_order_relaxed);
+            e.contended    = s.contended.load(std::memory_order_relaxed);
+            size_t key_len = s.key_len.load(std::memory_order_relaxed);
+            e.command      = loadText(s.command, CMD_BYTES);
+            e.key          = loadText(s.key, KEY_BYTES);
+            if (key_len > KEY_BYTES) e.key.replace(KEY_BYTES - 3, 3, "...");
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != 2 * ticket + 2) continue; // torn
+            out.push_back(std::move(e));
+        }
+        return out;
+    }
+
+    // Entries currently retained (upper bound: dropped writes still count).
+    size_t length() const {
+        uint64_t head  = next_.load(std::memory_order_acquire);
+        uint64_t floor = floor_.load(std::memory_order_acquire);
+        return static_cast<size_t>(std::min<uint64_t>(head - std::min(head, floor), capacity_));
+    }
+
+    void reset() { floor_.store(next_.load(std::memory_order_acquire), std::memory_order_release); }
+
+    size_t  capacity()        const { return capacity_; }
+    int64_t thresholdTicks()  const { return threshold_; }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};  // even = stable, odd = being written
+        std::atomic<int64_t>  timestamp_us{0};
+        std::atomic<uint64_t> duration_us{0};
+        std::atomic<uint64_t> value_bytes{0};
+        std::atomic<uint64_t> key_len{0};
+        std::atomic<bool>     contended{false};
+        std::atomic<uint64_t> command[CMD_BYTES / 8]{};
+        std::atomic<uint64_t> key[KEY_BYTES / 8]{};
+    };
+
+    // Text is packed into 8-byte words so every byte is written atomically.
+    static void storeText(std::atomic<uint64_t>* words, size_t bytes, const std::string& text) {
+        for (size_t w = 0; w < bytes / 8; ++w) {
+            char buf[8] = {};
+            size_t off = w * 8;
+            if (off < text.size()) std::memcpy(buf, text.data() + off, std::min<size_t>(8, text.size() - off));
+            uint64_t v;
+            std::memcpy(&v, buf, 8);
+            words[w].store(v, std::memory_order_relaxed);
+        }
+    }
+
+    static std::string loadText(const std::atomic<uint64_t>* words, size_t bytes) {
+        std::string out(bytes, '\0');
+        for (size_t w = 0; w < bytes / 8; ++w) {
+            uint64_t v = words[w].load(std::memory_order_relaxed);
+            std::memcpy(&out[w * 8], &v, 8);
+        }
+        out.resize(std::strlen(out.c_str()));
+        return out;
+    }
+
+    const size_t             capacity_;
+    const int64_t            threshold_;
+    const double             ns_per_tick_;
+    std::unique_ptr<Slot[]>  slots_;
+    std::atomic<uint64_t>    next_{0};
+    std::atomic<uint64_t>    floor_{0};
+};
@@ -2,16 +2,36 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 
+// Set when this thread had to wait for rw_mutex_; read-and-cleared by
+// takeLockContended() (slow log).
+static thread_local bool t_lock_contended = false;
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Constructor / Destructor
 // ─────────────────────────────────────────────────────────────────────────────
 
-KVStore::KVStore(size_t capacity)
-    : cache_(capacity),
+KVStore::KVStore(size_t capacity, size_t max_memory, EvictionPolicy policy,
+                 MaxmemoryPolicy mm_policy)
+    : max_memory_(max_memory),
+      mm_policy_(mm_policy),
+      rng_(std::random_device{}()),
+      cache_(capacity, policy),
       ttl_mgr_(std::chrono::milliseconds(500))
 {
+    if (mm_policy_ != MaxmemoryPolicy::ALLKEYS_LRU) {
+        cache_.setVictimPicker([this](const std::string* keep, std::string& victim) {
+            return pickVictim(keep, victim);
+        });
+    }
+    // The TTL index points at entry keys: follow them out of and around the cache
+    cache_.setDeadlineHooks(
+        [this](LRUCache::Entry& e) { ttl_mgr_.remove(e.key, e.expires); },
+        [this](const LRUCache::Entry& from, LRUCache::Entry& to) {
+            ttl_mgr_.move(to.expires, from.key, to.key);
+        });
     // Wire the TTL expiry callback
     ttl_mgr_.setExpireCallback([this](const std::string& key) {
         onExpire(key);
@@ -20,6 +40,8 @@ KVStore::KVStore(size_t capacity)
 }
 
 KVStore::~KVStore() {
+    stopDefrag();
+    bg_.reset(); // drains queued reclaim / free jobs, which use the members below
     ttl_mgr_.stop();
 }
 
@@ -30,23 +52,45 @@ KVStore::~KVStore() {
 std::string KVStore::set(const std::string& key, const std::string& value,
                           long long ttl_seconds)
 {
-    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
-    std::string evicted = cache_.set(key, value);
+    SetOptions opts;
+    opts.ttl_seconds = ttl_seconds;
+    auto evicted = set(key, value, opts).evicted;
+    return evicted.empty() ? std::string() : evicted.front();
+}
+
+SetResult KVStore::set(const std::string& key, const std::string& value,
+                       const SetOptions& opts)
+{
+    LatencyScope timer(latency_, LatencyTracker::SET);
+    SetResult result;
+    auto lock = lockExclusive();
+
+    const LRUCache::Entry* current = cache_.peek(key);
+    if (opts.return_old && current) result.old_value = current->str();
+    if ((opts.condition == SetOptions::Condition::IF_ABSENT  &&  current) ||
+        (opts.condition == SetOptions::Condition::IF_PRESENT && !current)) {
+        return result;
+    }
+
+    LRUCache::Entry* entry = nullptr;
+    std::string evicted = cache_.set(key, value, &entry);
     if (!evicted.empty()) {
-        ttl_mgr_.remove(evicted);
-        ++evictions_;
+        ++counters_.local().evictions;
+        result.evicted.push_back(std::move(evicted));
     }
 
     // Register TTL if specified
-    if (ttl_seconds > 0) {
-        ttl_mgr_.set(key, std::chrono::seconds(ttl_seconds));
-    } else {
+    if (opts.ttl_seconds > 0) {
+        ttl_mgr_.set(entry->key, entry->expires, std::chrono::seconds(opts.ttl_seconds));
+    } else if (!opts.keep_ttl) {
         // Clear any previous TTL on this key (e.g., re-SET without EX)
-        ttl_mgr_.remove(key);
+        ttl_mgr_.remove(entry->key, entry->expires);
     }
+    enforceLimits(result.evicted);
 
-    ++sets_;
-    return evicted;
+    ++counters_.local().sets;
+    result.applied = true;
+    return result;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -55,12 +99,13 @@ std::string KVStore::set(const std::string& key, const std::string& value,
 
 std::optional<std::string> KVStore::get(const std::string& key)
 {
-    std::shared_lock<std::shared_mutex> lock(rw_mutex_);
+    LatencyScope timer(latency_, LatencyTracker::GET);
+    auto lock = lockShared();
     auto result = cache_.get(key);
     if (result) {
-        ++hits_;
+        ++counters_.local().hits;
     } else {
-        ++misses_;
+        ++counters_.local().misses;
     }
     return result;
 }
@@ -71,24 +116,156 @@ std::optional<std::string> KVStore::get(const std::string& key)
 
 bool KVStore::del(const std::string& key)
 {
-    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
-    bool existed = cache_.del(key);
-    if (existed) {
-        ttl_mgr_.remove(key);
-        ++dels_;
-    }
+    LatencyScope timer(latency_, LatencyTracker::DEL);
+    auto lock = lockExclusive();
+    bool existed = cache_.del(key); // drops the TTL too
+    if (existed) ++counters_.local().dels;
     return existed;
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// MGET / MSET / MDEL
+// ─────────────────────────────────────────────────────────────────────────────
+
+std::vector<std::optional<std::string>>
+KVStore::mget(const std::vector<std::string>& keys)
+{
+    LatencyScope timer(latency_, LatencyTracker::MGET);
+    auto lock = lockShared();
+    auto result = cache_.getMany(keys);
+    uint64_t hit = 0;
+    for (auto& v : result) if (v) ++hit;
+    Counters& c = counters_.local();
+    c.hits   += hit;
+    c.misses += result.size() - hit;
+    return result;
+}
+
+std::vector<std::string>
+KVStore::mset(const std::vector<std::pair<std::string, std::string>>& pairs)
+{
+    LatencyScope timer(latency_, LatencyTracker::MSET);
+    std::vector<std::string> evicted;
+
+    auto lock = lockExclusive();
+    for (auto& [k, v] : pairs) {
+        LRUCache::Entry* entry = nullptr;
+        std::string ev = cache_.set(k, v, &entry);
+        if (!ev.empty()) evicted.push_back(std::move(ev));
+        ttl_mgr_.remove(entry->key, entry->expires); // written keys lose their TTL
+    }
+
+    Counters& c = counters_.local();
+    c.evictions += evicted.size();
+    c.sets      += pairs.size();
+    enforceLimits(evicted);
+    return evicted;
+}
+
+size_t KVStore::mdel(const std::vector<std::string>& keys)
+{
+    LatencyScope timer(latency_, LatencyTracker::MDEL);
+    size_t removed = 0;
+    auto lock = lockExclusive();
+    for (auto& k : keys) {
+        if (cache_.del(k)) ++removed;
+    }
+    counters_.local().dels += removed;
+    return removed;
+}
+
+size_t KVStore::unlink(const std::vector<std::string>& keys)
+{
+    LatencyScope timer(latency_, LatencyTracker::UNLINK);
+    size_t removed = 0;
+    auto lock = lockExclusive();
+    for (auto& k : keys) {
+        const LRUCache::Entry* e = cache_.peek(k);
+        if (!e) continue;
+        if (LRUCache::valueBytes(e->value) >= LAZYFREE_MIN_BYTES) cache_.unlink(k);
+        else                                                    cache_.del(k);
+        ++removed;
+    }
+    if (cache_.hasGraveyard()) freeLater(cache_.takeGraveyard());
+    counters_.local().dels += removed;
+    return removed;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// GETS / CAS
+// ─────────────────────────────────────────────────────────────────────────────
+
+std::optional<LRUCache::Versioned> KVStore::gets(const std::string& key)
+{
+    LatencyScope timer(latency_, LatencyTracker::GETS);
+    auto lock = lockShared();
+    auto result = cache_.getVersioned(key);
+    if (result) {
+        ++counters_.local().hits;
+    } else {
+        ++counters_.local().misses;
+    }
+    return result;
+}
+
+LRUCache::CasResult KVStore::cas(const std::string& key, const std::string& value,
+                                 uint64_t version, long long ttl_seconds)
+{
+    LatencyScope timer(latency_, LatencyTracker::CAS);
+    auto lock = lockExclusive();
+    auto result = cache_.compareAndSet(key, value, version);
+    if (result != LRUCache::CasResult::STORED) return result;
+
+    LRUCache::Entry* entry = cache_.peek(key);
+    if (ttl_seconds > 0) {
+        ttl_mgr_.set(entry->key, entry->expires, std::chrono::seconds(ttl_seconds));
+    } else {
+        ttl_mgr_.remove(entry->key, entry->expires);
+    }
+    ++counters_.local().sets;
+    std::vector<std::string> evicted;
+    enforceLimits(evicted);
+    return result;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// INCRBY
+// ─────────────────────────────────────────────────────────────────────────────
+
+long long KVStore::incrBy(const std::string& key, long long delta)
+{
+    LatencyScope timer(latency_, LatencyTracker::INCR);
+    int64_t result = 0;
+    {
+        // Fast path: existing counter, atomic add under the shared lock.
+        auto lock = lockShared();
+        if (cache_.incrementExisting(key, delta, result) == LRUCache::IncrResult::DONE) {
+            ++counters_.local().sets;
+            return result;
+        }
+    }
+
+    // Slow path: create the counter or convert a decimal string in place.
+    auto lock = lockExclusive();
+    std::vector<std::string> evicted;
+    std::string lru = cache_.increment(key, delta, result);
+    if (!lru.empty()) ++counters_.local().evictions;
+    ++counters_.local().sets;
+    enforceLimits(evicted);
+    return result;
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // TTL
 // ─────────────────────────────────────────────────────────────────────────────
 
 long long KVStore::ttl(const std::string& key) const
 {
-    std::shared_lock<std::shared_mutex> lock(rw_mutex_);
-    if (!cache_.contains(key)) return -2; // key doesn't exist
-    return ttl_mgr_.ttl(key);
+    LatencyScope timer(latency_, LatencyTracker::TTL);
+    auto lock = lockShared();
+    const LRUCache::Entry* entry = cache_.peek(key);
+    if (!entry) return -2; // key doesn't exist
+    return TTLManager::remaining<std::chrono::seconds>(entry->expires);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -97,11 +274,10 @@ long long KVStore::ttl(const std::string& key) const
 
 std::vector<std::string> KVStore::keys() const
 {
-    std::shared_lock<std::shared_mutex> lock(rw_mutex_);
+    LatencyScope timer(latency_, LatencyTracker::KEYS);
+    auto lock = lockShared();
     std::vector<std::string> result;
-    for (auto& [k, v] : cache_.entries()) {
-        result.push_back(k);
-    }
+    cache_.forEach([&result](const LRUCache::Entry& e) { result.push_back(e.key); });
     return result;
 }
 
@@ -109,13 +285,23 @@ std::vector<std::string> KVStore::keys() const
 // FLUSH
 // ─────────────────────────────────────────────────────────────────────────────
 
-void KVStore::flush()
+void KVStore::flush(bool async)
 {
-    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
-    cache_.clear();
-    // TTLManager doesn't have a bulk-clear public API but entries expire harmlessly
-    // We rely on TTLManager::snapshot being empty after stop/restart or harmless misfires.
-    // Simple approach: no keys → onExpire is a no-op.
+    LatencyScope timer(latency_, LatencyTracker::FLUSH);
+    auto lock = lockExclusive();
+    if (!async) {
+        ttl_mgr_.clear(); // first: it points into the entries
+        cache_.clear();
+        return;
+    }
+    // Moved into the job, so the last reference (and the free) is on the
+    // background thread.
+    auto cache = std::make_shared<LRUCache::Detached>(cache_.detach());
+    auto ttls  = std::make_shared<TTLManager::Detached>(ttl_mgr_.detach());
+    background().enqueue([cache = std::move(cache), ttls = std::move(ttls)]() mutable {
+        cache.reset();
+        ttls.reset();
+    });
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -124,18 +310,19 @@ void KVStore::flush()
 
 void KVStore::save(const std::string& filename) const
 {
+    LatencyScope timer(latency_, LatencyTracker::SAVE);
     std::vector<SnapshotEntry> entries;
     {
-        std::shared_lock<std::shared_mutex> lock(rw_mutex_);
-        for (auto& [k, v] : cache_.entries()) {
-            long long remaining_ms = ttl_mgr_.ttl_ms(k);
-            if (remaining_ms == 0) continue; // already expired, skip
+        auto lock = lockShared();
+        cache_.forEach([&](const LRUCache::Entry& entry) {
+            long long remaining_ms = TTLManager::remaining<std::chrono::milliseconds>(entry.expires);
+            if (remaining_ms == 0) return; // already expired, skip
             SnapshotEntry e;
-            e.key    = k;
-            e.value  = v;
+            e.key    = entry.key;
+            e.value  = entry.str(); // counters are persisted in decimal
             e.ttl_ms = remaining_ms; // -1 if no TTL
             entries.push_back(std::move(e));
-        }
+        });
     }
     PersistenceEngine::save(filename, entries);
 }
@@ -146,22 +333,27 @@ void KVStore::save(const std::string& filename) const
 
 void KVStore::load(const std::string& filename)
 {
+    LatencyScope timer(latency_, LatencyTracker::LOAD);
     auto raw = PersistenceEngine::load(filename);
     auto now = Clock::now();
 
-    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
+    auto lock = lockExclusive();
+    ttl_mgr_.clear();
     cache_.clear();
     for (auto& e : raw) {
         if (e.ttl_ms == 0) continue; // expired during load
 
-        cache_.set(e.key, e.value);
+        LRUCache::Entry* entry = nullptr;
+        cache_.set(e.key, e.value, &entry);
 
         if (e.ttl_ms > 0) {
             // Reconstruct absolute deadline
             auto deadline = now + std::chrono::milliseconds(e.ttl_ms);
-            ttl_mgr_.setAbsolute(e.key, deadline);
+            ttl_mgr_.set(entry->key, entry->expires, deadline);
         }
     }
+    std::vector<std::string> evicted;
+    enforceLimits(evicted);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -171,20 +363,45 @@ void KVStore::load(const std::string& filename)
 Stats KVStore::stats() const
 {
     Stats s;
-    s.hits         = hits_.load();
-    s.misses       = misses_.load();
-    s.evictions    = evictions_.load();
-    s.sets         = sets_.load();
-    s.dels         = dels_.load();
-    s.expirations  = expirations_.load();
+    counters_.forEach([&s](const Counters& c) {
+        s.hits        += c.hits.load();
+        s.misses      += c.misses.load();
+        s.evictions   += c.evictions.load();
+        s.sets        += c.sets.load();
+        s.dels        += c.dels.load();
+        s.expirations += c.expirations.load();
+    });
     s.current_keys = size();
     s.capacity     = capacity();
+    s.used_memory  = usedMemory();
+    s.max_memory   = max_memory_;
+    s.eviction_policy  = evictionPolicyName(cache_.policy());
+    s.maxmemory_policy = maxmemoryPolicyName(mm_policy_);
+    s.slabs            = SlabPool::instance().stats();
+    s.slab_fragmentation = SlabPool::fragmentation(s.slabs);
+    s.defrag_cycles      = defrag_cycles_.load(std::memory_order_relaxed);
+    s.defrag_moved       = defrag_moved_.load(std::memory_order_relaxed);
+    s.defrag_released    = SlabPool::instance().releasedBytes();
+    s.defrag_before      = defrag_before_.load(std::memory_order_relaxed);
+    s.defrag_after       = defrag_after_.load(std::memory_order_relaxed);
+    if (kLockStatsEnabled)
+        s.locks = {{"store", lockStatsOf(rw_mutex_)}, {"ttl", ttl_mgr_.lockStats()}};
     return s;
 }
 
+LatencyHistogram KVStore::latency(LatencyTracker::Command cmd) const
+{
+    return latency_.histogram(cmd);
+}
+
+void KVStore::resetLatency()
+{
+    latency_.reset();
+}
+
 size_t KVStore::size() const
 {
-    std::shared_lock<std::shared_mutex> lock(rw_mutex_);
+    auto lock = lockShared();
     return cache_.size();
 }
 
@@ -193,14 +410,249 @@ size_t KVStore::capacity() const
     return cache_.capacity();
 }
 
+size_t KVStore::usedMemory() const
+{
+    auto lock = lockShared();
+    return cache_.memoryUsage() + ttl_mgr_.memoryUsage();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// maxmemory — evict in one batch, sized from the overshoot
+// ─────────────────────────────────────────────────────────────────────────────
+
+void KVStore::enforceLimits(std::vector<std::string>& evicted)
+{
+    size_t used = cache_.memoryUsage() + ttl_mgr_.memoryUsage();
+    if (max_memory_ != 0 && used > max_memory_) {
+        // Victims per the cache's policy. Their entry bytes alone cover the
+        // overshoot; the TTLs they drop free extra.
+        auto batch = cache_.evictBytes(used - max_memory_);
+        counters_.local().evictions += batch.size();
+        evicted.insert(evicted.end(), std::make_move_iterator(batch.begin()),
+                       std::make_move_iterator(batch.end()));
+        used = cache_.memoryUsage() + ttl_mgr_.memoryUsage();
+    }
+    if (!async_evict_) return;
+
+    if (cache_.hasGraveyard()) freeLater(cache_.takeGraveyard());
+    bool over = (cache_.capacity() != LRUCache::UNLIMITED
+                 && cache_.size() + headroom_keys_ > cache_.capacity())
+             || (max_memory_ != 0 && used + headroom_bytes_ > max_memory_);
+    if (over && !reclaim_queued_.exchange(true, std::memory_order_relaxed))
+        background().enqueue([this] { reclaim(); });
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Async eviction — background reclaim and lazy free
+// ─────────────────────────────────────────────────────────────────────────────
+
+void KVStore::enableAsyncEviction(double headroom)
+{
+    if (headroom <= 0 || headroom >= 1)
+        throw std::invalid_argument("eviction headroom must be in (0, 1)");
+    auto lock = lockExclusive();
+    if (async_evict_) return;
+    const size_t cap = cache_.capacity();
+    if (cap != LRUCache::UNLIMITED)
+        headroom_keys_ = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(cap) * headroom));
+    headroom_bytes_ = static_cast<size_t>(static_cast<double>(max_memory_) * headroom);
+    cache_.setLazyFree(true);
+    async_evict_ = true;
+}
+
+void KVStore::reclaim()
+{
+    bool more = true;
+    while (more) {
+        LRUCache::Graveyard dead;
+        {
+            auto lock = lockExclusive();
+            reclaim_queued_.store(false, std::memory_order_relaxed); // later writes may requeue
+
+            std::vector<std::string> batch;
+            const size_t cap = cache_.capacity();
+            if (cap != LRUCache::UNLIMITED && cache_.size() + headroom_keys_ > cap)
+                batch = cache_.evictKeys(std::min(RECLAIM_BATCH,
+                                                  cache_.size() + headroom_keys_ - cap));
+            size_t used = cache_.memoryUsage() + ttl_mgr_.memoryUsage();
+            if (max_memory_ != 0 && used + headroom_bytes_ > max_memory_ && batch.size() < RECLAIM_BATCH) {
+                auto more_keys = cache_.evictBytes(used + headroom_bytes_ - max_memory_,
+                                                   RECLAIM_BATCH - batch.size());
+                batch.insert(batch.end(), std::make_move_iterator(more_keys.begin()),
+                             std::make_move_iterator(more_keys.end()));
+            }
+            counters_.local().evictions += batch.size();
+            more = batch.size() == RECLAIM_BATCH; // let waiting writers in between batches
+            dead = cache_.takeGraveyard();
+        }
+        dead.clear(); // the deallocation, outside the lock
+    }
+}
+
+void KVStore::freeLater(LRUCache::Graveyard dead)
+{
+    auto grave = std::make_shared<LRUCache::Graveyard>(std::move(dead));
+    background().enqueue([grave] { grave->clear(); });
+}
+
+ThreadPool& KVStore::background()
+{
+    if (!bg_) bg_ = std::make_unique<ThreadPool>(1);
+    return *bg_;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// MaxmemoryPolicy — victim choice for the random and volatile-* policies
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool KVStore::pickVictim(const std::string* keep, std::string& victim)
+{
+    static constexpr int SAMPLES = 5; // keys compared per volatile-lru pick
+
+    bool found = false;
+    switch (mm_policy_) {
+        case MaxmemoryPolicy::ALLKEYS_LRU:
+            return false;
+
+        case MaxmemoryPolicy::ALLKEYS_RANDOM:
+            for (int i = 0; i < SAMPLES && !found; ++i) {
+                const LRUCache::Entry* e = cache_.sample(rng_());
+                if (e && (!keep || e->key != *keep)) {
+                    victim = e->key;
+                    found  = true;
+                }
+            }
+            break;
+
+        case MaxmemoryPolicy::VOLATILE_RANDOM:
+        case MaxmemoryPolicy::VOLATILE_LRU: {
+            uint32_t best_idle = 0;
+            std::string key;
+            for (int i = 0; i < SAMPLES; ++i) {
+                if (!ttl_mgr_.sample(rng_(), key) || (keep && key == *keep)) continue;
+                uint32_t idle = cache_.idle(*cache_.peek(key));
+                if (!found || idle > best_idle) {
+                    victim    = key;
+                    best_idle = idle;
+                    found     = true;
+                }
+                if (mm_policy_ == MaxmemoryPolicy::VOLATILE_RANDOM) break;
+            }
+            break;
+        }
+
+        case MaxmemoryPolicy::VOLATILE_TTL:
+            found = ttl_mgr_.earliest(keep, victim);
+            break;
+    }
+    return found; // evicting the victim drops its TTL
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Lock acquisition — try first, so a wait can be flagged for the slow log
+// ─────────────────────────────────────────────────────────────────────────────
+
+std::unique_lock<KVStore::Mutex> KVStore::lockExclusive() const
+{
+    std::unique_lock<Mutex> lock(rw_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        t_lock_contended = true;
+        lock.lock();
+    }
+    return lock;
+}
+
+std::shared_lock<KVStore::Mutex> KVStore::lockShared() const
+{
+    std::shared_lock<Mutex> lock(rw_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        t_lock_contended = true;
+        lock.lock();
+    }
+    return lock;
+}
+
+bool KVStore::takeLockContended()
+{
+    bool contended = t_lock_contended;
+    t_lock_contended = false;
+    return contended;
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Private: TTL expiry callback (called from TTLManager worker thread)
 // ─────────────────────────────────────────────────────────────────────────────
 
 void KVStore::onExpire(const std::string& key)
 {
-    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
-    if (cache_.del(key)) {
-        ++expirations_;
+    auto lock = lockExclusive();
+    // The key may have been deleted, given a new TTL or persisted since
+    // its deadline was popped.
+    const LRUCache::Entry* entry = cache_.peek(key);
+    if (!entry || entry->expires == TimePoint{} || entry->expires > Clock::now()) return;
+    cache_.del(key);
+    ++counters_.local().expirations;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Active defragmentation
+// ─────────────────────────────────────────────────────────────────────────────
+
+void KVStore::enableActiveDefrag(double threshold)
+{
+    if (threshold <= 0) throw std::invalid_argument("defrag threshold must be > 0");
+    if (defrag_thread_.joinable()) return;
+    defrag_threshold_ = threshold;
+    defrag_thread_    = std::thread(&KVStore::defragLoop, this);
+}
+
+void KVStore::stopDefrag()
+{
+    {
+        std::lock_guard<std::mutex> lock(defrag_mutex_);
+        defrag_stop_ = true;
+    }
+    defrag_cv_.notify_all();
+    if (defrag_thread_.joinable()) defrag_thread_.join();
+}
+
+void KVStore::defragLoop()
+{
+    SlabPool& pool = SlabPool::instance();
+    double stuck = 0; // ratio a cycle could not improve; wait until it worsens
+    std::unique_lock<std::mutex> wait(defrag_mutex_);
+    while (!defrag_cv_.wait_for(wait, DEFRAG_INTERVAL, [this] { return defrag_stop_; })) {
+        const double before = SlabPool::fragmentation(pool.stats());
+        if (before <= 1.0 + defrag_threshold_ || before <= stuck * 1.01) continue;
+        if (pool.beginDefrag() == 0) continue;
+        const size_t released = pool.releasedBytes();
+
+        // One pass over the index, a time-bounded step per lock hold. A
+        // rehash between steps reshuffles the buckets, so the pass restarts.
+        size_t cursor = 0, moved = 0, buckets = 0;
+        do {
+            wait.unlock();
+            {
+                auto lock = lockExclusive();
+                if (cache_.bucketCount() != buckets) {
+                    buckets = cache_.bucketCount();
+                    cursor  = 0;
+                }
+                const auto deadline = Clock::now() + DEFRAG_STEP;
+                do cursor = cache_.defrag(cursor, 64, moved);
+                while (cursor != 0 && Clock::now() < deadline);
+            }
+            wait.lock();
+            if (cursor != 0) // as long again for the writers
+                defrag_cv_.wait_for(wait, DEFRAG_STEP, [this] { return defrag_stop_; });
+        } while (cursor != 0 && !defrag_stop_);
+        pool.endDefrag();
+
+        const double after = SlabPool::fragmentation(pool.stats());
+        stuck = pool.releasedBytes() == released ? after : 0;
+        defrag_cycles_.fetch_add(1, std::memory_order_relaxed);
+        defrag_moved_.fetch_add(moved, std::memory_order_relaxed);
+        defrag_before_.store(before, std::memory_order_relaxed);
+        defrag_after_.store(after, std::memory_order_relaxed);
     }
 }
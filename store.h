@@ -1,13 +1,64 @@
 #pragma once
+#include "lock_stats.h"
 #include "lru.h"
 #include "ttl_manager.h"
 #include "persistence.h"
+#include "latency.h"
+#include "thread_stripes.h"
+#include "threadpool.h"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <random>
 #include <shared_mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 #include <optional>
+#include <utility>
+
+/**
+ * MaxmemoryPolicy — which keys capacity / maxmemory eviction may pick
+ * (--maxmemory-policy). "lru" means the cache's EvictionPolicy order.
+ *
+ *   ALLKEYS_LRU      any key, in EvictionPolicy order (default)
+ *   ALLKEYS_RANDOM   any key, at random
+ *   VOLATILE_LRU     keys with a TTL; the least recently used of a sample
+ *   VOLATILE_RANDOM  keys with a TTL, at random
+ *   VOLATILE_TTL     keys with a TTL, soonest deadline first (exact, from
+ *                    TTLManager's deadline index)
+ *
+ * When no key qualifies, the volatile-* policies fall back to
+ * ALLKEYS_LRU: the capacity limit is hard, so a write never fails.
+ */
+enum class MaxmemoryPolicy {
+    ALLKEYS_LRU, ALLKEYS_RANDOM, VOLATILE_LRU, VOLATILE_RANDOM, VOLATILE_TTL
+};
+
+inline const char* maxmemoryPolicyName(MaxmemoryPolicy p) {
+    switch (p) {
+        case MaxmemoryPolicy::ALLKEYS_LRU:     return "allkeys-lru";
+        case MaxmemoryPolicy::ALLKEYS_RANDOM:  return "allkeys-random";
+        case MaxmemoryPolicy::VOLATILE_LRU:    return "volatile-lru";
+        case MaxmemoryPolicy::VOLATILE_RANDOM: return "volatile-random";
+        case MaxmemoryPolicy::VOLATILE_TTL:    return "volatile-ttl";
+    }
+    return "?";
+}
+
+// @throws std::invalid_argument for an unknown name.
+inline MaxmemoryPolicy parseMaxmemoryPolicy(const std::string& name) {
+    for (auto p : {MaxmemoryPolicy::ALLKEYS_LRU, MaxmemoryPolicy::ALLKEYS_RANDOM,
+                   MaxmemoryPolicy::VOLATILE_LRU, MaxmemoryPolicy::VOLATILE_RANDOM,
+                   MaxmemoryPolicy::VOLATILE_TTL})
+        if (name == maxmemoryPolicyName(p)) return p;
+    throw std::invalid_argument("unknown maxmemory policy: " + name
+                                + " (allkeys-lru | allkeys-random | volatile-lru"
+                                  " | volatile-random | volatile-ttl)");
+}
 
 /**
  * Stats — counters exposed by STATS command.
@@ -21,48 +72,151 @@ struct Stats {
     uint64_t expirations = 0;
     size_t   current_keys = 0;
     size_t   capacity     = 0;
+    size_t   used_memory  = 0;  // estimated bytes: entries, index, TTLs
+    size_t   max_memory   = 0;  // 0 = no byte limit
+    std::string eviction_policy;
+    std::string maxmemory_policy;
+    NamedLockStats locks;   // per-lock contention; empty unless built with LOCK_STATS
+    std::vector<SlabClassStats> slabs; // the process-wide SlabPool, per size class
+    double   slab_fragmentation = 1.0; // slab bytes reserved per byte in use
+    uint64_t defrag_cycles   = 0;
+    uint64_t defrag_moved    = 0;      // allocations relocated
+    size_t   defrag_released = 0;      // slab bytes returned to the OS (whole pool)
+    double   defrag_before   = 0;      // fragmentation when the last cycle started
+    double   defrag_after    = 0;      //   and when it ended
+};
+
+/**
+ * SetOptions — modifiers for SET, all applied under one exclusive lock.
+ *
+ *   NX       → condition = IF_ABSENT   (only create)
+ *   XX       → condition = IF_PRESENT  (only overwrite)
+ *   GET      → return_old              (reply with the previous value)
+ *   KEEPTTL  → keep_ttl                (retain the existing deadline)
+ */
+struct SetOptions {
+    enum class Condition { ALWAYS, IF_ABSENT, IF_PRESENT };
+
+    long long ttl_seconds = -1; // -1 = none (clears TTL unless keep_ttl)
+    Condition condition   = Condition::ALWAYS;
+    bool      return_old  = false;
+    bool      keep_ttl    = false;
+};
+
+/**
+ * SetResult — outcome of a conditional SET.
+ */
+struct SetResult {
+    bool                       applied = false; // false when NX / XX blocked the write
+    std::optional<std::string> old_value;       // previous value, only if return_old
+    std::vector<std::string>   evicted;         // keys evicted to make room
 };
 
 /**
  * KVStore — the main engine
  *
  * Combines:
- *   - LRUCache          : storage + eviction
- *   - TTLManager        : background expiry
+ *   - LRUCache          : storage + eviction (key count and/or maxmemory;
+ *                         EvictionPolicy order, or a MaxmemoryPolicy pick)
+ *   - TTLManager        : background expiry, deadline index for volatile-ttl;
+ *                         deadlines live in the cache entries, and the index
+ *                         points at their keys (LRUCache deadline hooks)
  *   - PersistenceEngine : snapshot save/load
  *
  * Thread safety:
  *   - std::shared_mutex allows concurrent reads (shared lock)
  *   - Writes acquire exclusive (unique) lock
  *   - TTL callback invoked from TTLManager thread locks exclusively
+ *   - Built with -DCHRONO_LOCK_STATS, rw_mutex_ and the TTLManager mutex
+ *     count acquisitions, waits and hold times (Stats::locks)
+ *
+ * Async eviction (enableAsyncEviction):
+ *   - A background thread keeps a headroom below each limit, evicting in
+ *     batches of at most RECLAIM_BATCH keys per exclusive-lock hold, so
+ *     writes rarely reach a limit and evict inline.
+ *   - Evicted entries are freed on that thread (lazy free), whichever
+ *     thread evicted them: a writer never pays for free() of a large value.
+ *
+ * Active defragmentation (enableActiveDefrag):
+ *   - A thread checks the SlabPool every DEFRAG_INTERVAL. Past the
+ *     threshold it starts a cycle, or joins the one another store started:
+ *     the pool drains its sparsest slabs, and LRUCache::defrag() moves this
+ *     store's objects out of them in steps of at most DEFRAG_STEP under the
+ *     exclusive lock, so writes wait at most that long. Emptied slabs go
+ *     back to the OS as they empty.
  */
 class KVStore {
 public:
     static constexpr size_t DEFAULT_CAPACITY = 10'000;
     static constexpr const char* SNAPSHOT_FILE = "snapshot.bin";
 
-    explicit KVStore(size_t capacity = DEFAULT_CAPACITY);
+    // capacity:   key-count limit (LRUCache::UNLIMITED for none).
+    // max_memory: byte limit on usedMemory(), 0 for none. Writes that push
+    //             past it evict keys in one batch until back under.
+    // policy:     the cache's eviction order.
+    // mm_policy:  which keys capacity / max_memory eviction may pick.
+    explicit KVStore(size_t capacity = DEFAULT_CAPACITY, size_t max_memory = 0,
+                     EvictionPolicy policy = EvictionPolicy::LRU,
+                     MaxmemoryPolicy mm_policy = MaxmemoryPolicy::ALLKEYS_LRU);
     ~KVStore();
 
     // SET key value [ttl seconds, -1 = none]
-    // Returns name of evicted key or "" if none.
+    // Returns the name of the (first) evicted key or "" if none.
     std::string set(const std::string& key, const std::string& value,
                     long long ttl_seconds = -1);
 
+    // SET key value [NX|XX] [GET] [EX n|KEEPTTL] → check, read-old and write
+    // happen atomically under a single exclusive lock acquisition.
+    SetResult set(const std::string& key, const std::string& value,
+                  const SetOptions& opts);
+
     // GET key → value or nullopt if missing/expired.
     std::optional<std::string> get(const std::string& key);
 
     // DEL key → true if key existed.
     bool del(const std::string& key);
 
+    // GETS key → value plus its CAS token, or nullopt if missing.
+    std::optional<LRUCache::Versioned> gets(const std::string& key);
+
+    // CAS key value version [ttl] → stores only if the key is unchanged since
+    // the GETS that returned `version`. TTL handling matches set().
+    LRUCache::CasResult cas(const std::string& key, const std::string& value,
+                            uint64_t version, long long ttl_seconds = -1);
+
+    // INCRBY key delta → new value. A missing key starts at 0; a string value
+    // holding a decimal integer is converted to a native counter on first use.
+    // Increments of an existing counter run under the shared lock.
+    // @throws std::invalid_argument if the value is not an integer.
+    // @throws std::overflow_error if the result would overflow int64.
+    long long incrBy(const std::string& key, long long delta);
+
+    // ── Multi-key operations: one lock acquisition per batch ──────────────────
+
+    // MGET k1 k2 ... → one entry per key, nullopt where missing.
+    std::vector<std::optional<std::string>> mget(const std::vector<std::string>& keys);
+
+    // MSET k1 v1 k2 v2 ... → clears any TTL on the written keys (like SET
+    // without EX). Returns the keys evicted to make room.
+    std::vector<std::string> mset(
+        const std::vector<std::pair<std::string, std::string>>& pairs);
+
+    // MDEL k1 k2 ... → number of keys that existed.
+    size_t mdel(const std::vector<std::string>& keys);
+
+    // UNLINK k1 k2 ... → like MDEL, but values of LAZYFREE_MIN_BYTES or more
+    // are freed on the background thread instead of under the lock.
+    size_t unlink(const std::vector<std::string>& keys);
+
     // TTL for key in seconds; -1 = no TTL; 0 = expired.
     long long ttl(const std::string& key) const;
 
     // List all keys (non-expired).
     std::vector<std::string> keys() const;
 
-    // Flush all keys and TTLs.
-    void flush();
+    // Flush all keys and TTLs. With `async`, the data is detached in O(1)
+    // under the lock and destroyed on the background thread (FLUSH ASYNC).
+    void flush(bool async = false);
 
     // Persist to disk.
     void save(const std::string& filename = SNAPSHOT_FILE) const;
@@ -73,22 +227,102 @@ public:
     // Return a copy of stats.
     Stats stats() const;
 
-    size_t size()     const;
-    size_t capacity() const;
+    // Latency of one command type since the last resetLatency(), in ns.
+    // Every public operation is timed, including time spent waiting for locks.
+    LatencyHistogram latency(LatencyTracker::Command cmd) const;
+    void             resetLatency();
+
+    size_t size()        const;
+    size_t capacity()    const;
+    size_t usedMemory()  const;  // see MemoryUsage for the cost model
+    size_t maxMemory()   const { return max_memory_; }
+    MaxmemoryPolicy maxmemoryPolicy() const { return mm_policy_; }
+
+    // Starts background eviction down to `headroom` (a fraction, e.g. 0.05)
+    // below the key-count and byte limits, with lazy free. Call once.
+    void enableAsyncEviction(double headroom);
+    bool asyncEviction() const { return async_evict_; }
+
+    // Starts background defragmentation of the SlabPool, cycling whenever
+    // its fragmentation exceeds 1 + `threshold` (e.g. 0.1: slabs reserve
+    // 10% more than they hand out). Call once.
+    void enableActiveDefrag(double threshold);
+    bool activeDefrag() const { return defrag_thread_.joinable(); }
+
+    // True if the calling thread waited for the store lock since the previous
+    // call, which clears the flag. Lets the dispatch layer's slow log tell
+    // lock waits apart from slow work.
+    static bool takeLockContended();
 
 private:
-    // Called by TTLManager when a key expires.
+    using Mutex = ProfiledMutex<std::shared_mutex>;
+
+    std::unique_lock<Mutex> lockExclusive() const;
+    std::shared_lock<Mutex> lockShared()    const;
+
+    // Enforces max_memory_ after a write; appends evicted keys. In async
+    // mode, also hands evicted entries to the background thread and wakes it
+    // past the headroom. Caller holds the exclusive lock.
+    void enforceLimits(std::vector<std::string>& evicted);
+
+    // Background job: evicts down to the low watermarks, then frees the
+    // evicted entries outside the lock.
+    void reclaim();
+    void freeLater(LRUCache::Graveyard dead);
+
+    // The reclaim / lazy-free thread, started on first use. Caller holds the
+    // exclusive lock.
+    ThreadPool& background();
+
+    // The defrag thread: waits for fragmentation, then runs a cycle.
+    void defragLoop();
+    void stopDefrag();
+
+    // LRUCache::VictimPicker for the non-default MaxmemoryPolicy values.
+    // Caller holds the exclusive lock.
+    bool pickVictim(const std::string* keep, std::string& victim);
+
+    // Called by TTLManager when a key's deadline is popped; deletes it if
+    // that is still its deadline.
     void onExpire(const std::string& key);
 
-    mutable std::shared_mutex  rw_mutex_;
+    mutable Mutex              rw_mutex_;
+    const size_t               max_memory_;
+    const MaxmemoryPolicy      mm_policy_;
+    std::mt19937_64            rng_;        // victim sampling; exclusive lock
     LRUCache                   cache_;
     TTLManager                 ttl_mgr_;
 
-    // Atomic counters (no mutex needed for stats).
-    mutable std::atomic<uint64_t> hits_{0};
-    mutable std::atomic<uint64_t> misses_{0};
-    std::atomic<uint64_t>         evictions_{0};
-    std::atomic<uint64_t>         sets_{0};
-    std::atomic<uint64_t>         dels_{0};
-    std::atomic<uint64_t>         expirations_{0};
+    // Async eviction; set once by enableAsyncEviction().
+    static constexpr size_t     RECLAIM_BATCH = 256;
+    bool                        async_evict_    = false;
+    size_t                      headroom_keys_  = 0;
+    size_t                      headroom_bytes_ = 0;
+    std::atomic<bool>           reclaim_queued_{false};
+    std::unique_ptr<ThreadPool> bg_;            // one thread: reclaim + lazy free
+
+    // Active defrag; started once by enableActiveDefrag().
+    static constexpr auto       DEFRAG_INTERVAL = std::chrono::milliseconds(100);
+    static constexpr auto       DEFRAG_STEP     = std::chrono::microseconds(1000); // lock hold
+    std::thread                 defrag_thread_;
+    std::mutex                  defrag_mutex_;
+    std::condition_variable     defrag_cv_;
+    bool                        defrag_stop_      = false;
+    double                      defrag_threshold_ = 0;
+    std::atomic<uint64_t>       defrag_cycles_{0};
+    std::atomic<uint64_t>       defrag_moved_{0};
+    std::atomic<double>         defrag_before_{0};
+    std::atomic<double>         defrag_after_{0};
+
+    // UNLINK frees smaller values inline: a handoff costs more than free().
+    static constexpr size_t     LAZYFREE_MIN_BYTES = 64 * 1024;
+
+    // Stats counters, striped per thread: an operation only ever writes its
+    // own thread's cache line, and stats() sums the stripes on read.
+    struct Counters {
+        StripeCounter hits, misses, evictions, sets, dels, expirations;
+    };
+    ThreadStripes<Counters>       counters_;
+
+    mutable LatencyTracker        latency_;
 };
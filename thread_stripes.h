@@ -0,0 +1,146 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+/**
+ * StripeCounter — a counter with exactly one writer (its stripe's thread).
+ * Increments are a relaxed load + store, so there is no lock prefix and no RMW,
+ * and other threads may read the value at any time. The stripe's zeroed
+ * storage supplies its initial value.
+ */
+struct StripeCounter {
+    std::atomic<uint64_t> value;
+
+    StripeCounter& operator+=(uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        return *this;
+    }
+    StripeCounter& operator++() { return *this += 1; }
+    uint64_t load() const { return value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * ThreadStripes<T> — one cache-line-aligned T per thread, aggregated on read
+ *
+ * Hot-path state (counters, histograms) that many threads update goes in a
+ * per-thread stripe, so writers never share a cache line. local() returns
+ * the calling thread's stripe. After the first call it costs one
+ * thread_local compare. forEach() visits every stripe for aggregation.
+ *
+ * T's fields must be safe to read while their owning thread writes them,
+ * e.g. std::atomic updated with relaxed load + store (a single writer needs
+ * no read-modify-write).
+ *
+ * Lifetime: when a thread exits, its stripe is released, not freed. Its
+ * contents stay in the totals and the next new thread reuses it, so a
+ * thread-per-connection server does not grow without bound. Stripes are
+ * shared_ptr-owned, so a thread that outlives the ThreadStripes, or the
+ * reverse, never touches freed memory.
+ *
+ * Large stripes (>= 64 KiB, e.g. histogram arrays) are mapped straight from
+ * the OS. The pages arrive zeroed and only become resident once touched,
+ * and a thread's first operation never pays for a large malloc, which can
+ * trigger a heap consolidation.
+ */
+template <typename T>
+class ThreadStripes {
+public:
+    ThreadStripes() : id_(nextId()) {}
+    ThreadStripes(const ThreadStripes&)            = delete;
+    ThreadStripes& operator=(const ThreadStripes&) = delete;
+
+    T& local() {
+        Cache& c = cache();
+        if (c.owner == id_) return *c.value;
+        return acquire(c);
+    }
+
+    // Calls f(const T&) for every stripe ever handed out, live or released.
+    template <typename F>
+    void forEach(F&& f) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& s : slots_) f(static_cast<const T&>(s->value));
+    }
+
+private:
+    struct alignas(64) Slot {
+        T                 value;   // zeroed by allocate(), not by a constructor
+        std::atomic<bool> in_use{true};
+    };
+
+    static constexpr size_t MMAP_MIN = 64 * 1024;
+
+    static std::shared_ptr<Slot> allocate() {
+#ifndef _WIN32
+        if (sizeof(Slot) >= MMAP_MIN) {
+            void* mem = mmap(nullptr, sizeof(Slot), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) throw std::bad_alloc();
+            return std::shared_ptr<Slot>(new (mem) Slot, [](Slot* p) {
+                p->~Slot();
+                munmap(p, sizeof(Slot));
+            });
+        }
+#endif
+        return std::shared_ptr<Slot>(new Slot());
+    }
+
+    // Last stripe this thread used (fast path), and every stripe it holds.
+    struct Cache { uint64_t owner = 0; T* value = nullptr; };
+    struct Leases {
+        std::vector<std::pair<uint64_t, std::shared_ptr<Slot>>> held;
+        ~Leases() { for (auto& l : held) l.second->in_use.store(false, std::memory_order_release); }
+    };
+
+    static Cache&  cache()  { thread_local Cache c;  return c; }
+    static Leases& leases() { thread_local Leases l; return l; }
+
+    static uint64_t nextId() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    T& acquire(Cache& c) {
+        Leases& mine = leases();
+        for (auto& l : mine.held)
+            if (l.first == id_) { c = {id_, &l.second->value}; return *c.value; }
+
+        std::shared_ptr<Slot> slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& s : slots_) {
+                bool free = false;
+                if (s->in_use.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                    slot = s;
+                    break;
+                }
+            }
+            if (!slot) {
+                slot = allocate();
+                slots_.push_back(slot);
+            }
+        }
+
+        // Drop leases on stripe sets that no longer exist.
+        auto& held = mine.held;
+        for (size_t i = 0; i < held.size();)
+            if (held[i].second.use_count() == 1) { held[i] = std::move(held.back()); held.pop_back(); }
+            else ++i;
+
+        held.emplace_back(id_, slot);
+        c = {id_, &slot->value};
+        return *c.value;
+    }
+
+    const uint64_t                     id_;
+    mutable std::mutex                 mutex_;
+    std::vector<std::shared_ptr<Slot>> slots_;
+};
@@ -1,12 +1,16 @@
 #pragma once
+#include "lock_stats.h"
+#include "memory_usage.h"
+
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using Clock     = std::chrono::steady_clock;
@@ -15,16 +19,34 @@ using TimePoint = std::chrono::steady_clock::time_point;
 /**
  * TTLManager — background expiry engine
  *
- * Maintains a map of key → expiry_time.
+ * Keeps every key's deadline ordered by time. The owner stores each key and
+ * its deadline itself (in the cache entry); the index only points at that
+ * key, so setting or clearing a TTL neither copies nor hashes the key.
  * A dedicated std::thread wakes every `interval_ms` milliseconds,
- * scans for expired keys, and calls the user-supplied `on_expire` callback.
+ * pops expired keys off the front of the index, and calls the user-supplied
+ * `on_expire` callback. The index also serves volatile-ttl eviction.
+ *
+ * Contract: set(), remove() and move() run under the owner's exclusive
+ * lock, which also guards the deadline slots they update. An indexed key
+ * must stay put until it is removed or moved; the expiry thread reads it.
+ * The owner's stored deadline may outlive a popped index entry, so
+ * `on_expire` must check it before deleting the key.
  *
- * Thread safety: all map accesses are protected by a std::mutex.
+ * Thread safety: all index accesses are protected by a std::mutex
+ * (a ProfiledMutex, so STATS can report its contention in LOCK_STATS builds).
  * Shutdown: destructor signals the thread via condition_variable.
+ * Memory: memoryUsage() estimates the index's heap bytes for maxmemory; it is
+ * updated under the mutex and readable without it.
  */
 class TTLManager {
 public:
     using ExpireCallback = std::function<void(const std::string&)>;
+    using Deadline       = std::pair<TimePoint, const std::string*>; // index entry
+
+    // Every TTL as detach() hands it over.
+    struct Detached {
+        std::set<Deadline> order;
+    };
 
     explicit TTLManager(std::chrono::milliseconds interval = std::chrono::milliseconds(500))
         : interval_(interval), running_(false) {}
@@ -34,44 +56,55 @@ public:
     // Register a callback that is invoked with the expired key.
     void setExpireCallback(ExpireCallback cb) { on_expire_ = std::move(cb); }
 
-    // Set or refresh TTL for a key (absolute deadline).
-    void set(const std::string& key, std::chrono::seconds ttl_secs) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        expiry_map_[key] = Clock::now() + ttl_secs;
+    // Set or refresh the TTL of `key`, whose current deadline is `slot`
+    // ({} = none); `slot` becomes `deadline`.
+    void set(const std::string& key, TimePoint& slot, TimePoint deadline) {
+        std::lock_guard<Mutex> lock(mutex_);
+        if (slot != TimePoint{}) by_deadline_.erase({slot, &key});
+        by_deadline_.insert({deadline, &key});
+        slot = deadline;
+        account();
+    }
+
+    void set(const std::string& key, TimePoint& slot, std::chrono::seconds ttl_secs) {
+        set(key, slot, Clock::now() + ttl_secs);
     }
 
-    // Remove TTL entry (e.g. when key is DEL'd manually).
-    void remove(const std::string& key) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        expiry_map_.erase(key);
+    // Remove the TTL (e.g. when key is DEL'd manually); no-op without one.
+    void remove(const std::string& key, TimePoint& slot) {
+        if (slot == TimePoint{}) return;
+        std::lock_guard<Mutex> lock(mutex_);
+        by_deadline_.erase({slot, &key});
+        slot = TimePoint{};
+        account();
     }
 
-    // Returns remaining TTL in seconds; -1 if no TTL; -2 if already expired.
-    long long ttl(const std::string& key) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = expiry_map_.find(key);
-        if (it == expiry_map_.end()) return -1;
-        auto remaining = std::chrono::duration_cast<std::chrono::seconds>(
-            it->second - Clock::now()
-        ).count();
-        return remaining > 0 ? remaining : 0;
+    // The owner moved a key with deadline `deadline` from `from` to `to`.
+    void move(TimePoint deadline, const std::string& from, const std::string& to) {
+        std::lock_guard<Mutex> lock(mutex_);
+        if (by_deadline_.erase({deadline, &from})) by_deadline_.insert({deadline, &to});
     }
 
-    // Returns remaining TTL in milliseconds for persistence use.
-    long long ttl_ms(const std::string& key) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = expiry_map_.find(key);
-        if (it == expiry_map_.end()) return -1;
-        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
-            it->second - Clock::now()
-        ).count();
-        return remaining > 0 ? remaining : 0;
+    // Time left until `deadline` in whole `Unit`s, 0 once passed; -1 for
+    // no TTL ({}).
+    template <typename Unit>
+    static long long remaining(TimePoint deadline) {
+        if (deadline == TimePoint{}) return -1;
+        auto left = std::chrono::duration_cast<Unit>(deadline - Clock::now()).count();
+        return left > 0 ? left : 0;
     }
 
-    // Re-insert with absolute deadline (used during snapshot load).
-    void setAbsolute(const std::string& key, TimePoint deadline) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        expiry_map_[key] = deadline;
+    // Drops every TTL (FLUSH). The owner resets its deadline slots.
+    void clear() { detach(); }
+
+    // Empties the index in O(1) and returns it for the caller to destroy
+    // elsewhere (FLUSH ASYNC).
+    Detached detach() {
+        std::lock_guard<Mutex> lock(mutex_);
+        Detached d;
+        d.order.swap(by_deadline_);
+        account();
+        return d;
     }
 
     void start() {
@@ -81,7 +114,7 @@ public:
 
     void stop() {
         {
-            std::lock_guard<std::mutex> lock(mutex_);
+            std::lock_guard<Mutex> lock(mutex_);
             running_ = false;
         }
         cv_.notify_all();
@@ -90,28 +123,65 @@ public:
 
     bool isRunning() const { return running_.load(); }
 
-    // Snapshot helper: get a snapshot of the TTL map.
-    std::unordered_map<std::string, TimePoint> snapshot() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return expiry_map_;
+    LockStats lockStats() const { return lockStatsOf(mutex_); }
+
+    // Estimated heap bytes held by the index (see MemoryUsage).
+    size_t memoryUsage() const { return used_bytes_.load(std::memory_order_relaxed); }
+
+    // ── Eviction candidates (volatile-* maxmemory policies) ─────────────────
+
+    size_t size() const {
+        std::lock_guard<Mutex> lock(mutex_);
+        return by_deadline_.size();
+    }
+
+    // The key with the soonest deadline other than `keep`; false if none.
+    bool earliest(const std::string* keep, std::string& key) const {
+        std::lock_guard<Mutex> lock(mutex_);
+        for (auto& [deadline, k] : by_deadline_) {
+            if (k == keep) continue;
+            key = *k;
+            return true;
+        }
+        return false;
+    }
+
+    // A pseudo-random key with a TTL; false if none. Picks a time between
+    // the first and last deadline and takes the next key due, so keys after
+    // a long gap are picked more often, like sampleEntry's sparse buckets.
+    bool sample(uint64_t r, std::string& key) const {
+        std::lock_guard<Mutex> lock(mutex_);
+        if (by_deadline_.empty()) return false;
+        const TimePoint first = by_deadline_.begin()->first;
+        const auto span   = static_cast<uint64_t>((by_deadline_.rbegin()->first - first).count());
+        const auto offset = static_cast<Clock::rep>(r % (span + 1));
+        key = *by_deadline_.lower_bound({first + Clock::duration(offset), nullptr})->second;
+        return true;
     }
 
 private:
+    using Mutex = ProfiledMutex<std::mutex>;
+
+    // Keeps used_bytes_ in step with the index; caller holds mutex_.
+    void account() {
+        used_bytes_.store(by_deadline_.size() * MemoryUsage::treeNode<Deadline>(),
+                          std::memory_order_relaxed);
+    }
+
     void run() {
         while (true) {
-            std::unique_lock<std::mutex> lock(mutex_);
+            std::unique_lock<Mutex> lock(mutex_);
             cv_.wait_for(lock, interval_, [this] { return !running_.load(); });
             if (!running_) break;
 
-            // Collect expired keys first to avoid modifying map during iteration
+            // Expired keys are a prefix of the index
             std::vector<std::string> expired_keys;
             auto now = Clock::now();
-            for (auto& [key, deadline] : expiry_map_) {
-                if (now >= deadline) expired_keys.push_back(key);
-            }
-            for (auto& key : expired_keys) {
-                expiry_map_.erase(key);
+            while (!by_deadline_.empty() && by_deadline_.begin()->first <= now) {
+                expired_keys.push_back(*by_deadline_.begin()->second);
+                by_deadline_.erase(by_deadline_.begin());
             }
+            account();
             lock.unlock(); // Release before calling callback (callback acquires store mutex)
 
             if (on_expire_) {
@@ -124,9 +194,10 @@ private:
 
     std::chrono::milliseconds                      interval_;
     std::atomic<bool>                              running_;
-    mutable std::mutex                             mutex_;
-    std::condition_variable                        cv_;
+    mutable Mutex                                  mutex_;
+    ProfiledCondVar                                cv_;
     std::thread                                    worker_;
-    std::unordered_map<std::string, TimePoint>     expiry_map_;
+    std::set<Deadline>                             by_deadline_; // soonest first
     ExpireCallback                                 on_expire_;
+    std::atomic<size_t>                            used_bytes_{0};
 };
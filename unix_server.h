@@ -0,0 +1,313 @@
+#pragma once
+#ifndef _WIN32
+#include "executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Sockets here are close-on-exec and never raise SIGPIPE. Linux sets both
+// per call (SOCK_CLOEXEC, accept4, MSG_NOSIGNAL); elsewhere (macOS) the
+// socket itself is marked after it is created or accepted.
+#ifdef MSG_NOSIGNAL
+constexpr int UNIX_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int UNIX_SEND_FLAGS = 0;
+#endif
+
+#ifndef __linux__
+inline int unixMarkSocket(int fd) {
+    if (fd < 0) return fd;
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    return fd;
+}
+#endif
+
+// A new AF_UNIX stream socket; -1 on error.
+inline int unixSocket() {
+#ifdef __linux__
+    return ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+    return unixMarkSocket(::socket(AF_UNIX, SOCK_STREAM, 0));
+#endif
+}
+
+// The next connection on `listen_fd`; -1 on error.
+inline int unixAccept(int listen_fd) {
+#ifdef __linux__
+    return ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+    return unixMarkSocket(::accept(listen_fd, nullptr, nullptr));
+#endif
+}
+
+/**
+ * UnixSocketServer — AF_UNIX stream listener for co-located clients
+ *
+ * Skips the TCP/IP stack entirely: no checksums, no loopback routing, no
+ * Nagle. Each accepted connection gets its own thread that reads inline
+ * command lines, runs them through CommandExecutor and writes RESP replies.
+ * Pipelined requests are answered in order. A connection that sends more
+ * than MAX_LINE bytes without a newline gets an error and is closed.
+ *
+ * Shutdown: stop() shuts down the listening and client sockets, which wakes
+ * every blocked accept()/read(), then joins all threads and unlinks the path.
+ */
+class UnixSocketServer {
+public:
+    static constexpr size_t MAX_LINE = 1 << 20; // bytes of one command line
+
+    UnixSocketServer(const CommandExecutor& exec, std::string path)
+        : exec_(exec), path_(std::move(path)) {}
+
+    ~UnixSocketServer() { stop(); }
+
+    UnixSocketServer(const UnixSocketServer&)            = delete;
+    UnixSocketServer& operator=(const UnixSocketServer&) = delete;
+
+    // Binds and starts the accept thread.
+    // @throws std::runtime_error if the socket cannot be bound.
+    void start() {
+        sockaddr_un addr{};
+        if (path_.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("Unix socket path too long: " + path_);
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+
+        listen_fd_ = unixSocket();
+        if (listen_fd_ < 0) throw std::runtime_error(sysError("socket"));
+
+        ::unlink(path_.c_str()); // stale socket from an unclean shutdown
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(listen_fd_, SOMAXCONN) < 0) {
+            std::string msg = sysError("bind " + path_);
+            ::close(listen_fd_);
+            listen_fd_ = -1;
+            throw std::runtime_error(msg);
+        }
+
+        running_ = true;
+        acceptor_ = std::thread(&UnixSocketServer::acceptLoop, this);
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) return;
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        if (acceptor_.joinable()) acceptor_.join();
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+
+        std::lock_guard<std::mutex> lock(conns_mutex_);
+        for (auto& c : conns_) ::shutdown(c->fd, SHUT_RDWR);
+        for (auto& c : conns_) {
+            if (c->worker.joinable()) c->worker.join();
+            ::close(c->fd);
+        }
+        conns_.clear();
+        ::unlink(path_.c_str());
+    }
+
+    const std::string& path() const { return path_; }
+
+private:
+    struct Connection {
+        int               fd = -1;
+        std::thread       worker;
+        std::atomic<bool> done{false};
+    };
+
+    void acceptLoop() {
+        while (running_) {
+            int fd = unixAccept(listen_fd_);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                break; // listening socket shut down
+            }
+            std::lock_guard<std::mutex> lock(conns_mutex_);
+            reapFinished();
+            auto conn = std::make_unique<Connection>();
+            conn->fd = fd;
+            Connection* raw = conn.get();
+            conn->worker = std::thread([this, raw] { serve(*raw); });
+            conns_.push_back(std::move(conn));
+        }
+    }
+
+    // Joins connections whose client already hung up. Caller holds conns_mutex_.
+    void reapFinished() {
+        for (auto it = conns_.begin(); it != conns_.end();) {
+            if ((*it)->done) {
+                (*it)->worker.join();
+                ::close((*it)->fd);
+                it = conns_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void serve(Connection& conn) {
+        std::string inbuf, outbuf;
+        char chunk[16 * 1024];
+        size_t scanned = 0; // inbuf[0, scanned) holds no newline
+        bool close = false;
+        while (!close) {
+            ssize_t n = ::read(conn.fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            inbuf.append(chunk, static_cast<size_t>(n));
+
+            // Answer every complete line in the buffer, then flush once. Only
+            // the bytes just read can hold a new newline.
+            size_t start = 0, nl;
+            while (!close && (nl = inbuf.find('\n', std::max(start, scanned))) != std::string::npos) {
+                size_t end = nl;
+                if (end > start && inbuf[end - 1] == '\r') --end;
+                if (end - start > MAX_LINE) break; // rejected below
+                if (end > start)
+                    outbuf += exec_.execute(inbuf.substr(start, end - start), close);
+                start = nl + 1;
+            }
+            inbuf.erase(0, start);
+            scanned = inbuf.size();
+            if (!close && inbuf.size() > MAX_LINE) {
+                outbuf += CommandExecutor::error("command line too long");
+                close = true;
+            }
+            if (!writeAll(conn.fd, outbuf)) break;
+            outbuf.clear();
+        }
+        ::shutdown(conn.fd, SHUT_RDWR); // the client sees EOF now, not when reaped
+        conn.done = true;
+    }
+
+    static bool writeAll(int fd, const std::string& data) {
+        size_t off = 0;
+        while (off < data.size()) {
+            ssize_t n = ::send(fd, data.data() + off, data.size() - off, UNIX_SEND_FLAGS);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            off += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    static std::string sysError(const std::string& what) {
+        return what + ": " + std::strerror(errno);
+    }
+
+    const CommandExecutor&                   exec_;
+    std::string                              path_;
+    int                                      listen_fd_ = -1;
+    std::atomic<bool>                        running_{false};
+    std::thread                              acceptor_;
+    std::mutex                               conns_mutex_;
+    std::list<std::unique_ptr<Connection>>   conns_;
+};
+
+/**
+ * UnixSocketClient — minimal blocking client for UnixSocketServer
+ *
+ * request() sends one inline command and returns the raw RESP reply,
+ * including nested arrays. Intended for tools and benchmarks.
+ */
+class UnixSocketClient {
+public:
+    explicit UnixSocketClient(const std::string& path) {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("Unix socket path too long: " + path);
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        fd_ = unixSocket();
+        if (fd_ < 0 ||
+            ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            std::string msg = std::string("connect ") + path + ": " + std::strerror(errno);
+            if (fd_ >= 0) ::close(fd_);
+            throw std::runtime_error(msg);
+        }
+    }
+
+    ~UnixSocketClient() { if (fd_ >= 0) ::close(fd_); }
+
+    UnixSocketClient(const UnixSocketClient&)            = delete;
+    UnixSocketClient& operator=(const UnixSocketClient&) = delete;
+
+    // Sends `line` (newline appended) and blocks for the complete reply.
+    // @throws std::runtime_error if the connection drops.
+    std::string request(const std::string& line) {
+        std::string out = line + "\n";
+        size_t off = 0;
+        while (off < out.size()) {
+            ssize_t n = ::send(fd_, out.data() + off, out.size() - off, UNIX_SEND_FLAGS);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error("Unix socket send failed");
+            off += static_cast<size_t>(n);
+        }
+        std::string reply;
+        readReply(reply);
+        return reply;
+    }
+
+private:
+    // Appends one complete RESP value to `out`.
+    void readReply(std::string& out) {
+        std::string header = readLine();
+        out += header;
+        out += "\r\n";
+        if (header.empty()) throw std::runtime_error("Malformed reply");
+        char kind = header[0];
+        if (kind == '$') {
+            long long len = std::stoll(header.substr(1));
+            if (len >= 0) out += readExact(static_cast<size_t>(len) + 2);
+        } else if (kind == '*') {
+            long long count = std::stoll(header.substr(1));
+            for (long long i = 0; i < count; ++i) readReply(out);
+        }
+    }
+
+    std::string readLine() {
+        size_t nl;
+        while ((nl = buf_.find("\r\n")) == std::string::npos) fill();
+        std::string line = buf_.substr(0, nl);
+        buf_.erase(0, nl + 2);
+        return line;
+    }
+
+    std::string readExact(size_t n) {
+        while (buf_.size() < n) fill();
+        std::string s = buf_.substr(0, n);
+        buf_.erase(0, n);
+        return s;
+    }
+
+    void fill() {
+        char chunk[16 * 1024];
+        ssize_t n;
+        do { n = ::read(fd_, chunk, sizeof(chunk)); } while (n < 0 && errno == EINTR);
+        if (n <= 0) throw std::runtime_error("Unix socket closed by server");
+        buf_.append(chunk, static_cast<size_t>(n));
+    }
+
+    int         fd_ = -1;
+    std::string buf_;
+};
+
+#endif // !_WIN32
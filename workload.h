@@ -0,0 +1,210 @@
+#pragma once
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * workload.h — YCSB core workloads and request-key generators
+ *
+ * Generators follow the YCSB reference implementation (Gray et al.,
+ * "Quickly Generating Billion-Record Synthetic Databases"):
+ *
+ *   UNIFORM    every record equally likely
+ *   ZIPFIAN    record i drawn with p ∝ 1 / (i+1)^θ, θ = 0.99 — low ids are hot
+ *   SCRAMBLED  Zipfian popularity, but hot records are spread over the
+ *              keyspace by FNV-hashing the rank (no hot "prefix")
+ *   LATEST     Zipfian over recency: the most recently inserted records
+ *              are the hottest (workload D)
+ *
+ * All generators are immutable after construction and take the caller's
+ * RNG, so one instance can be shared by every benchmark thread. The Zipfian
+ * constants are computed once for the initial record count; records inserted
+ * during the run phase are reached through LATEST, not by regrowing zeta.
+ */
+
+enum class KeyDistribution { UNIFORM, ZIPFIAN, SCRAMBLED, LATEST };
+
+inline uint64_t fnv1a64(uint64_t v) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (int i = 0; i < 8; ++i) {
+        h ^= v & 0xFF;
+        h *= 0x100000001B3ull;
+        v >>= 8;
+    }
+    return h;
+}
+
+class ZipfianGenerator {
+public:
+    static constexpr double THETA = 0.99;
+
+    explicit ZipfianGenerator(uint64_t items, double zetan = 0.0) : items_(items) {
+        if (items_ == 0) throw std::invalid_argument("Zipfian item count must be > 0");
+        zetan_ = zetan > 0 ? zetan : zeta(items_);
+        alpha_ = 1.0 / (1.0 - THETA);
+        double zeta2 = zeta(2);
+        eta_   = (1.0 - std::pow(2.0 / static_cast<double>(items_), 1.0 - THETA))
+               / (1.0 - zeta2 / zetan_);
+        half_pow_theta_ = 1.0 + std::pow(0.5, THETA);
+    }
+
+    // Rank in [0, items): 0 is the most popular.
+    template <typename Rng>
+    uint64_t next(Rng& rng) const {
+        double u  = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double uz = u * zetan_;
+        if (uz < 1.0)             return 0;
+        if (uz < half_pow_theta_) return 1;
+        auto r = static_cast<uint64_t>(static_cast<double>(items_)
+                                       * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return r < items_ ? r : items_ - 1;
+    }
+
+    uint64_t items() const { return items_; }
+
+    static double zeta(uint64_t n) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; ++i) sum += 1.0 / std::pow(static_cast<double>(i), THETA);
+        return sum;
+    }
+
+private:
+    uint64_t items_;
+    double   zetan_;
+    double   alpha_;
+    double   eta_;
+    double   half_pow_theta_;
+};
+
+/**
+ * KeyChooser — picks record ids according to a KeyDistribution.
+ */
+class KeyChooser {
+public:
+    // YCSB's scrambled generator draws from a fixed 10^10-item Zipfian whose
+    // zeta is precomputed, then hashes into the real keyspace.
+    static constexpr uint64_t SCRAMBLED_ITEMS = 10'000'000'000ull;
+    static constexpr double   SCRAMBLED_ZETAN = 26.46902820178302;
+
+    KeyChooser(KeyDistribution dist, uint64_t records)
+        : dist_(dist), records_(records),
+          zipf_(dist == KeyDistribution::SCRAMBLED
+                    ? ZipfianGenerator(SCRAMBLED_ITEMS, SCRAMBLED_ZETAN)
+                    : ZipfianGenerator(records ? records : 1)) {}
+
+    // `inserted` = records currently present (>= initial record count).
+    template <typename Rng>
+    uint64_t next(Rng& rng, uint64_t inserted) const {
+        switch (dist_) {
+            case KeyDistribution::UNIFORM:
+                return std::uniform_int_distribution<uint64_t>(0, inserted - 1)(rng);
+            case KeyDistribution::ZIPFIAN:
+                return zipf_.next(rng);
+            case KeyDistribution::SCRAMBLED:
+                return fnv1a64(zipf_.next(rng)) % records_;
+            case KeyDistribution::LATEST: {
+                uint64_t back = zipf_.next(rng);
+                return back < inserted ? inserted - 1 - back : 0;
+            }
+        }
+        return 0;
+    }
+
+private:
+    KeyDistribution  dist_;
+    uint64_t         records_;
+    ZipfianGenerator zipf_;
+};
+
+/**
+ * WorkloadSpec — operation mix of one YCSB core workload.
+ *
+ * SCAN has no ordered-range equivalent in ChronoStore (the index is a hash
+ * map); the benchmark issues it as an MGET of `scan_length` consecutive
+ * record keys, which exercises the same multi-key read path.
+ */
+struct WorkloadSpec {
+    char            name = 'A';
+    std::string     description;
+    double          read   = 0;
+    double          update = 0;
+    double          insert = 0;
+    double          scan   = 0;
+    double          rmw    = 0;  // read-modify-write (GETS + CAS)
+    KeyDistribution dist   = KeyDistribution::ZIPFIAN;
+    size_t          max_scan_length = 100;
+};
+
+inline WorkloadSpec ycsbWorkload(char w) {
+    WorkloadSpec s;
+    s.name = static_cast<char>(std::toupper(static_cast<unsigned char>(w)));
+    switch (s.name) {
+        case 'A': s.description = "update heavy (50/50 read/update)";
+                  s.read = 0.50; s.update = 0.50; break;
+        case 'B': s.description = "read mostly (95/5 read/update)";
+                  s.read = 0.95; s.update = 0.05; break;
+        case 'C': s.description = "read only";
+                  s.read = 1.00; break;
+        case 'D': s.description = "read latest (95/5 read/insert)";
+                  s.read = 0.95; s.insert = 0.05; s.dist = KeyDistribution::LATEST; break;
+        case 'E': s.description = "short ranges (95/5 scan/insert)";
+                  s.scan = 0.95; s.insert = 0.05; break;
+        case 'F': s.description = "read-modify-write (50/50 read/rmw)";
+                  s.read = 0.50; s.rmw = 0.50; break;
+        default:
+            throw std::invalid_argument(std::string("Unknown YCSB workload: ") + w);
+    }
+    return s;
+}
+
+inline KeyDistribution parseDistribution(const std::string& name) {
+    if (name == "uniform")   return KeyDistribution::UNIFORM;
+    if (name == "zipfian")   return KeyDistribution::ZIPFIAN;
+    if (name == "scrambled") return KeyDistribution::SCRAMBLED;
+    if (name == "latest")    return KeyDistribution::LATEST;
+    throw std::invalid_argument("Unknown distribution: " + name);
+}
+
+inline const char* distributionName(KeyDistribution d) {
+    switch (d) {
+        case KeyDistribution::UNIFORM:   return "uniform";
+        case KeyDistribution::ZIPFIAN:   return "zipfian";
+        case KeyDistribution::SCRAMBLED: return "scrambled";
+        case KeyDistribution::LATEST:    return "latest";
+    }
+    return "?";
+}
+
+/**
+ * ValuePool — pre-generated values so the run phase never builds strings.
+ * Sizes are uniform in [min_size, max_size].
+ */
+class ValuePool {
+public:
+    static constexpr size_t POOL = 1024;
+
+    ValuePool(size_t min_size, size_t max_size, uint32_t seed = 7) {
+        if (max_size < min_size) max_size = min_size;
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<size_t> len(min_size, max_size);
+        std::uniform_int_distribution<int>    chr('a', 'z');
+        values_.reserve(POOL);
+        for (size_t i = 0; i < POOL; ++i) {
+            std::string v(len(rng), '\0');
+            for (auto& c : v) c = static_cast<char>(chr(rng));
+            values_.push_back(std::move(v));
+        }
+    }
+
+    template <typename Rng>
+    const std::string& pick(Rng& rng) const {
+        return values_[std::uniform_int_distribution<size_t>(0, POOL - 1)(rng)];
+    }
+
+private:
+    std::vector<std::string> values_;
+};